@@ -0,0 +1,124 @@
+//
+//  AllocationTracker.cpp
+//  PipesAndFiltersFramework
+//
+//  Created by Antti Juustila on 19.10.2026.
+//  Copyright (c) 2026 Antti Juustila. All rights reserved.
+//
+
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+
+#include <StudentNodeElements/AllocationTracker.h>
+#include <StudentNodeElements/MetricsRegistry.h>
+
+
+namespace OHARStudent {
+   
+   thread_local AllocationStage * AllocationStage::current = nullptr;
+   
+   /** Creates the stage, registering its counters if allocation accounting is enabled.
+    @param handlerName The handler the allocations are attributed to in the metrics. */
+   AllocationStage::AllocationStage(const std::string & handlerName)
+   : allocations(nullptr), allocatedBytes(nullptr), frees(nullptr)
+   {
+      if (isEnabled()) {
+         allocations = &MetricsRegistry::get().counter(handlerName, "allocations");
+         allocatedBytes = &MetricsRegistry::get().counter(handlerName, "allocated_bytes");
+         frees = &MetricsRegistry::get().counter(handlerName, "frees");
+      }
+   }
+   
+   /** @returns True if the library was built with allocation accounting. */
+   bool AllocationStage::isEnabled() {
+#ifdef SNE_ALLOCATION_ACCOUNTING
+      return true;
+#else
+      return false;
+#endif
+   }
+   
+   void AllocationStage::countAllocation(std::size_t bytes) noexcept {
+      AllocationStage * stage = current;
+      if (stage && stage->allocations) {
+         stage->allocations->add();
+         stage->allocatedBytes->add(bytes);
+      }
+   }
+   
+   void AllocationStage::countFree() noexcept {
+      AllocationStage * stage = current;
+      if (stage && stage->frees) {
+         stage->frees->add();
+      }
+   }
+   
+   
+} //namespace
+
+
+#ifdef SNE_ALLOCATION_ACCOUNTING
+
+// Replacements of the global allocation functions, counting the allocations into the
+// stage active in the calling thread. Memory comes from malloc, as with the default ones.
+
+namespace {
+   
+   void * allocate(std::size_t size) {
+      void * memory = std::malloc(size > 0 ? size : 1);
+      if (!memory) {
+         throw std::bad_alloc();
+      }
+      OHARStudent::AllocationStage::countAllocation(size);
+      return memory;
+   }
+   
+   void * allocateAligned(std::size_t size, std::align_val_t alignment) {
+      void * memory = nullptr;
+      std::size_t align = std::max(static_cast<std::size_t>(alignment), sizeof(void*));
+      if (posix_memalign(&memory, align, size > 0 ? size : 1) != 0) {
+         throw std::bad_alloc();
+      }
+      OHARStudent::AllocationStage::countAllocation(size);
+      return memory;
+   }
+   
+   void release(void * memory) noexcept {
+      if (memory) {
+         OHARStudent::AllocationStage::countFree();
+         std::free(memory);
+      }
+   }
+   
+} //namespace
+
+void * operator new(std::size_t size) { return allocate(size); }
+void * operator new[](std::size_t size) { return allocate(size); }
+void * operator new(std::size_t size, const std::nothrow_t &) noexcept {
+   try { return allocate(size); } catch (...) { return nullptr; }
+}
+void * operator new[](std::size_t size, const std::nothrow_t &) noexcept {
+   try { return allocate(size); } catch (...) { return nullptr; }
+}
+void * operator new(std::size_t size, std::align_val_t alignment) { return allocateAligned(size, alignment); }
+void * operator new[](std::size_t size, std::align_val_t alignment) { return allocateAligned(size, alignment); }
+void * operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t &) noexcept {
+   try { return allocateAligned(size, alignment); } catch (...) { return nullptr; }
+}
+void * operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t &) noexcept {
+   try { return allocateAligned(size, alignment); } catch (...) { return nullptr; }
+}
+
+void operator delete(void * memory) noexcept { release(memory); }
+void operator delete[](void * memory) noexcept { release(memory); }
+void operator delete(void * memory, std::size_t) noexcept { release(memory); }
+void operator delete[](void * memory, std::size_t) noexcept { release(memory); }
+void operator delete(void * memory, const std::nothrow_t &) noexcept { release(memory); }
+void operator delete[](void * memory, const std::nothrow_t &) noexcept { release(memory); }
+void operator delete(void * memory, std::align_val_t) noexcept { release(memory); }
+void operator delete[](void * memory, std::align_val_t) noexcept { release(memory); }
+void operator delete(void * memory, std::size_t, std::align_val_t) noexcept { release(memory); }
+void operator delete[](void * memory, std::size_t, std::align_val_t) noexcept { release(memory); }
+
+#endif
@@ -0,0 +1,223 @@
+//
+//  CompressedOutput.cpp
+//  PipesAndFiltersFramework
+//
+//  Created by Antti Juustila on 19.10.2026.
+//  Copyright (c) 2026 Antti Juustila. All rights reserved.
+//
+
+#include <g3log/g3log.hpp>
+
+#ifdef SNE_WITH_ZLIB
+#include <zlib.h>
+#endif
+
+#include <StudentNodeElements/CompressedOutput.h>
+
+
+namespace OHARStudent {
+   
+   const std::string CompressedOutput::TAG{"CompressedOutput "};
+   
+#ifdef SNE_WITH_ZLIB
+   struct CompressedOutput::Stream {
+      z_stream zs;
+      char out[64 * 1024];
+   };
+#else
+   struct CompressedOutput::Stream {
+   };
+#endif
+   
+   /** @returns True if the library was built with zlib and can write compressed files. */
+   bool CompressedOutput::isAvailable() {
+#ifdef SNE_WITH_ZLIB
+      return true;
+#else
+      return false;
+#endif
+   }
+   
+   /**
+    Opens the file for compressed data and starts the compression thread. A gzip file is
+    appended to, a zlib file is replaced.
+    @param fileName The file to write.
+    @param format Gzip or zlib format.
+    @param level The compression level, 1 (fastest) to 9 (smallest).
+    */
+   CompressedOutput::CompressedOutput(const std::string & fileName, Format format, int level)
+   : file(nullptr), unfinished(0), closing(false), failed(false)
+   {
+#ifdef SNE_WITH_ZLIB
+      stream = std::make_unique<Stream>();
+      stream->zs = z_stream();
+      // Window bits + 16 writes a gzip header and trailer instead of the zlib ones.
+      const int windowBits = format == Format::Gzip ? 15 + 16 : 15;
+      if (deflateInit2(&stream->zs, level, Z_DEFLATED, windowBits, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+         LOG(WARNING) << TAG << "Could not initialize compression for " << fileName;
+         stream.reset();
+         return;
+      }
+      // Gzip members can follow each other in a file, but a zlib stream must be the only one.
+      file = std::fopen(fileName.c_str(), format == Format::Gzip ? "ab" : "wb");
+      if (!file) {
+         LOG(WARNING) << TAG << "Could not open " << fileName << " for writing.";
+         deflateEnd(&stream->zs);
+         stream.reset();
+         return;
+      }
+      compressor = std::thread(&CompressedOutput::compressChunks, this);
+#else
+      (void)format;
+      (void)level;
+      LOG(WARNING) << TAG << "Built without zlib, cannot write " << fileName;
+#endif
+   }
+   
+   /** Compresses the data still queued, finishes the compressed stream and closes the file. */
+   CompressedOutput::~CompressedOutput() {
+      close();
+   }
+   
+   /** @returns True if the file is open and data can be written. */
+   bool CompressedOutput::isOpen() const {
+      return file != nullptr;
+   }
+   
+   /**
+    Queues data to be compressed into the file. Waits if the compression thread is too
+    far behind.
+    @param data The data to write.
+    @param length The number of bytes to write.
+    */
+   void CompressedOutput::write(const char * data, std::size_t length) {
+      if (!file || length == 0) {
+         return;
+      }
+      std::unique_lock<std::mutex> lock(queueGuard);
+      if (failed) {
+         return;
+      }
+      queueChanged.wait(lock, [this] { return queue.size() < MaxQueuedChunks; });
+      queue.push_back(Chunk{std::string(data, length), false});
+      unfinished++;
+      queueChanged.notify_all();
+   }
+   
+   /** Waits until the data written so far has been compressed and written into the file,
+    so that it can be decompressed by a reader.
+    @returns False if the file is not open or compressing or writing has failed. */
+   bool CompressedOutput::flush() {
+      if (!file) {
+         return false;
+      }
+      std::unique_lock<std::mutex> lock(queueGuard);
+      queue.push_back(Chunk{std::string(), true});
+      unfinished++;
+      queueChanged.notify_all();
+      queueChanged.wait(lock, [this] { return unfinished == 0; });
+      return !failed;
+   }
+   
+   /** Compresses the data still queued, finishes the compressed stream and closes the file.
+    @returns False if the file was not open or compressing or writing has failed. */
+   bool CompressedOutput::close() {
+      if (!file) {
+         return false;
+      }
+      {
+         std::lock_guard<std::mutex> guard(queueGuard);
+         closing = true;
+      }
+      queueChanged.notify_all();
+      if (compressor.joinable()) {
+         compressor.join();
+      }
+#ifdef SNE_WITH_ZLIB
+      if (!failed && !deflateChunk(std::string(), Z_FINISH)) {
+         failed = true;
+      }
+      deflateEnd(&stream->zs);
+#endif
+      if (std::fclose(file) != 0 && !failed) {
+         LOG(WARNING) << TAG << "Could not write the compressed file.";
+         failed = true;
+      }
+      file = nullptr;
+      return !failed;
+   }
+   
+   /** The compression thread: compresses the queued chunks until closed. */
+   void CompressedOutput::compressChunks() {
+      std::unique_lock<std::mutex> lock(queueGuard);
+      while (true) {
+         queueChanged.wait(lock, [this] { return !queue.empty() || closing; });
+         if (queue.empty()) {
+            break;
+         }
+         Chunk chunk = std::move(queue.front());
+         queue.pop_front();
+         queueChanged.notify_all();
+         if (failed) {
+            // The file is incomplete anyway; only let the waiters go on.
+            unfinished--;
+            queueChanged.notify_all();
+            continue;
+         }
+         lock.unlock();
+         bool written = true;
+#ifdef SNE_WITH_ZLIB
+         if (chunk.flush) {
+            written = deflateChunk(std::string(), Z_SYNC_FLUSH);
+            if (written && std::fflush(file) != 0) {
+               LOG(WARNING) << TAG << "Could not write the compressed file.";
+               written = false;
+            }
+         } else {
+            written = deflateChunk(chunk.data, Z_NO_FLUSH);
+         }
+#endif
+         lock.lock();
+         if (!written) {
+            failed = true;
+         }
+         unfinished--;
+         queueChanged.notify_all();
+      }
+   }
+   
+   /**
+    Compresses data into the file.
+    @param data The data to compress.
+    @param mode The zlib flush mode.
+    @returns True if the compressed data was written.
+    */
+   bool CompressedOutput::deflateChunk(const std::string & data, int mode) {
+#ifdef SNE_WITH_ZLIB
+      z_stream & zs = stream->zs;
+      zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+      zs.avail_in = static_cast<uInt>(data.length());
+      do {
+         zs.next_out = reinterpret_cast<Bytef*>(stream->out);
+         zs.avail_out = sizeof(stream->out);
+         int result = deflate(&zs, mode);
+         if (result == Z_STREAM_ERROR) {
+            LOG(WARNING) << TAG << "Compression failed.";
+            return false;
+         }
+         std::size_t produced = sizeof(stream->out) - zs.avail_out;
+         if (produced > 0 && std::fwrite(stream->out, 1, produced, file) != produced) {
+            LOG(WARNING) << TAG << "Could not write the compressed file.";
+            return false;
+         }
+      } while (zs.avail_out == 0);
+      return true;
+#else
+      (void)data;
+      (void)mode;
+      return false;
+#endif
+   }
+   
+   
+} //namespace
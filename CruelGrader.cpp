@@ -16,23 +16,17 @@ namespace OHARStudent {
     @returns The grade for the student.
     */
    int CruelGrader::calculate(const StudentDataItem & source) {
-      int grade = 0; // Assume failed; cruel eh?
-      int examPoints = source.getExamPoints();
-      int exercisePoints = source.getExercisePointsTotal();
-      int exerciseWorkPoints = source.getCourseProjectPoints();
-      if (examPoints < 12) {
-         return grade; // failed
-      }
-      if (examPoints >= 12 && examPoints <18) {
-         grade = 1;
-      } else {
-         grade = 2;
-      }
-      grade += ((exercisePoints / 2) + exerciseWorkPoints)/10;
-      if (grade >= 5) { // Cruel, eh?
-         grade = 4;
-      }
-      return grade;
+      return CruelPolicy::grade(source); // Failed below 12 exam points, never a 5; cruel eh?
+   }
+   
+   // The rules are evaluated at compile time.
+   static_assert(CruelPolicy::grade(11, 100, 40) == 0, "Fails below 12 exam points");
+   static_assert(CruelPolicy::grade(12, 0, 0) == 1 && CruelPolicy::grade(18, 0, 0) == 2, "Exam bands");
+   static_assert(CruelPolicy::grade(18, 20, 9) == 3, "One more for each 10 bonus points");
+   static_assert(CruelPolicy::grade(30, 100, 40) == 4, "Never a 5");
+   
+   std::string CruelGrader::getName() const {
+      return "cruel";
    }
 
 
@@ -0,0 +1,154 @@
+//
+//  DelimiterScanner.cpp
+//  PipesAndFiltersFramework
+//
+//  Created by Antti Juustila on 19.10.2026.
+//  Copyright (c) 2026 Antti Juustila. All rights reserved.
+//
+
+#include <StudentNodeElements/DelimiterScanner.h>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define SNE_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+
+namespace OHARStudent {
+   
+   namespace {
+      
+      /** Adds the delimiters flagged in the mask of a block starting at offset. */
+      inline void addDelimiters(uint32_t offset, uint32_t mask, uint32_t newlineMask, DelimiterScanner::Index & index) {
+         while (mask) {
+            const uint32_t bit = static_cast<uint32_t>(__builtin_ctz(mask));
+            if (newlineMask & (1u << bit)) {
+               index.recordEnds.push_back(static_cast<uint32_t>(index.delimiters.size()));
+            }
+            index.delimiters.push_back(offset + bit);
+            mask &= mask - 1;
+         }
+      }
+      
+      void scanScalar(const char * data, std::size_t begin, std::size_t length, DelimiterScanner::Index & index) {
+         for (std::size_t offset = begin; offset < length; offset++) {
+            const char byte = data[offset];
+            if (byte == '\t') {
+               index.delimiters.push_back(static_cast<uint32_t>(offset));
+            } else if (byte == '\n') {
+               index.recordEnds.push_back(static_cast<uint32_t>(index.delimiters.size()));
+               index.delimiters.push_back(static_cast<uint32_t>(offset));
+            }
+         }
+      }
+      
+#ifdef SNE_X86_SIMD
+      __attribute__((target("sse2")))
+      void scanSSE2(const char * data, std::size_t length, DelimiterScanner::Index & index) {
+         const __m128i tabs = _mm_set1_epi8('\t');
+         const __m128i newlines = _mm_set1_epi8('\n');
+         std::size_t offset = 0;
+         for (; offset + 16 <= length; offset += 16) {
+            const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + offset));
+            const uint32_t newlineMask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(block, newlines)));
+            const uint32_t tabMask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(block, tabs)));
+            addDelimiters(static_cast<uint32_t>(offset), tabMask | newlineMask, newlineMask, index);
+         }
+         scanScalar(data, offset, length, index);
+      }
+      
+      __attribute__((target("avx2")))
+      void scanAVX2(const char * data, std::size_t length, DelimiterScanner::Index & index) {
+         const __m256i tabs = _mm256_set1_epi8('\t');
+         const __m256i newlines = _mm256_set1_epi8('\n');
+         std::size_t offset = 0;
+         for (; offset + 32 <= length; offset += 32) {
+            const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + offset));
+            const uint32_t newlineMask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, newlines)));
+            const uint32_t tabMask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, tabs)));
+            addDelimiters(static_cast<uint32_t>(offset), tabMask | newlineMask, newlineMask, index);
+         }
+         scanScalar(data, offset, length, index);
+      }
+#endif
+      
+   } // namespace
+   
+   /**
+    Scans a buffer with the best implementation the CPU supports. The delimiters found are
+    appended to the index.
+    @param data The buffer.
+    @param length The length of the buffer, less than 4 GiB.
+    @param index The index the delimiter offsets are added to.
+    */
+   void DelimiterScanner::scan(const char * data, std::size_t length, Index & index) {
+      static const Implementation best = getBestImplementation();
+      scan(best, data, length, index);
+   }
+   
+   /**
+    Scans a buffer with the given implementation, which must be supported by the CPU.
+    @param implementation The implementation to use.
+    @param data The buffer.
+    @param length The length of the buffer, less than 4 GiB.
+    @param index The index the delimiter offsets are added to.
+    */
+   void DelimiterScanner::scan(Implementation implementation, const char * data, std::size_t length, Index & index) {
+      // A rough guess of the number of fields, to avoid growing the vector many times.
+      index.delimiters.reserve(index.delimiters.size() + length / 4);
+      switch (implementation) {
+#ifdef SNE_X86_SIMD
+         case Implementation::AVX2:
+            scanAVX2(data, length, index);
+            break;
+         case Implementation::SSE2:
+            scanSSE2(data, length, index);
+            break;
+#endif
+         default:
+            scanScalar(data, 0, length, index);
+            break;
+      }
+   }
+   
+   /** @returns The fastest implementation supported by the CPU. */
+   DelimiterScanner::Implementation DelimiterScanner::getBestImplementation() {
+      if (isSupported(Implementation::AVX2)) {
+         return Implementation::AVX2;
+      }
+      if (isSupported(Implementation::SSE2)) {
+         return Implementation::SSE2;
+      }
+      return Implementation::Scalar;
+   }
+   
+   /** @returns True if the implementation can be used on this CPU. */
+   bool DelimiterScanner::isSupported(Implementation implementation) {
+      switch (implementation) {
+#ifdef SNE_X86_SIMD
+         case Implementation::AVX2:
+            return __builtin_cpu_supports("avx2");
+         case Implementation::SSE2:
+            return __builtin_cpu_supports("sse2");
+#endif
+         case Implementation::Scalar:
+            return true;
+         default:
+            return false;
+      }
+   }
+   
+   /** @returns The name of the implementation, for logging. */
+   const char * DelimiterScanner::getName(Implementation implementation) {
+      switch (implementation) {
+         case Implementation::AVX2:
+            return "AVX2";
+         case Implementation::SSE2:
+            return "SSE2";
+         default:
+            return "scalar";
+      }
+   }
+   
+   
+} //namespace
@@ -0,0 +1,147 @@
+//
+//  FlowControl.cpp
+//  PipesAndFiltersFramework
+//
+//  Created by Antti Juustila on 19.10.2026.
+//  Copyright (c) 2026 Antti Juustila. All rights reserved.
+//
+
+#include <StudentNodeElements/FlowControl.h>
+#include <StudentNodeElements/MetricsRegistry.h>
+
+
+namespace OHARStudent {
+   
+   thread_local FlowCredit * FlowCredit::current = nullptr;
+   
+   /** Creates an empty credit, not holding anything. */
+   FlowCredit::FlowCredit()
+   : owner(nullptr)
+   {
+   }
+   
+   FlowCredit::FlowCredit(FlowControl * owner)
+   : owner(owner)
+   {
+   }
+   
+   FlowCredit::FlowCredit(FlowCredit && another)
+   : owner(another.owner)
+   {
+      another.owner = nullptr;
+   }
+   
+   FlowCredit & FlowCredit::operator = (FlowCredit && another) {
+      if (this != &another) {
+         release();
+         owner = another.owner;
+         another.owner = nullptr;
+      }
+      return *this;
+   }
+   
+   FlowCredit::~FlowCredit() {
+      release();
+   }
+   
+   /** Returns the credit to the FlowControl, if not returned already. */
+   void FlowCredit::release() {
+      if (owner) {
+         owner->release();
+         owner = nullptr;
+      }
+   }
+   
+   bool FlowCredit::isValid() const {
+      return owner != nullptr;
+   }
+   
+   /** Takes the credit of the item the calling thread is currently handling.
+    @returns The credit, or an empty credit if the thread has none. */
+   FlowCredit FlowCredit::takeCurrent() {
+      if (current) {
+         return std::move(*current);
+      }
+      return FlowCredit();
+   }
+   
+   FlowCredit::Scope::Scope(FlowCredit & credit)
+   : previous(FlowCredit::current)
+   {
+      FlowCredit::current = &credit;
+   }
+   
+   FlowCredit::Scope::~Scope() {
+      FlowCredit::current = previous;
+   }
+   
+   /**
+    Creates the flow control.
+    @param handlerName The handler the in flight metrics are reported for.
+    @param maxInFlight Maximum number of items in flight, zero for no limit.
+    */
+   FlowControl::FlowControl(const std::string & handlerName, std::size_t maxInFlight)
+   : maxInFlight(maxInFlight), inFlight(0),
+   inFlightGauge(MetricsRegistry::get().gauge(handlerName, "in_flight"))
+   {
+   }
+   
+   FlowControl::~FlowControl() {
+   }
+   
+   /** Changes the limit. Producers waiting for credits are woken up to check the new limit.
+    @param newMax Maximum number of items in flight, zero for no limit. */
+   void FlowControl::setMaxInFlight(std::size_t newMax) {
+      {
+         std::lock_guard<std::mutex> guard(flowGuard);
+         maxInFlight = newMax;
+      }
+      creditReturned.notify_all();
+   }
+   
+   /** Acquires a credit for an item, blocking while the maximum number of items are in flight.
+    @param cancelFlag If set and true, stops waiting. May be null.
+    @returns The credit, returned when the credit object is destroyed or released. An empty
+    credit (not valid) if cancelled. */
+   FlowCredit FlowControl::acquire(const std::atomic<bool> * cancelFlag) {
+      std::unique_lock<std::mutex> lock(flowGuard);
+      creditReturned.wait(lock, [this, cancelFlag] {
+         return (cancelFlag && cancelFlag->load()) || maxInFlight == 0 || inFlight < maxInFlight;
+      });
+      if (cancelFlag && cancelFlag->load()) {
+         return FlowCredit();
+      }
+      inFlight++;
+      inFlightGauge.set(static_cast<int64_t>(inFlight));
+      return FlowCredit(this);
+   }
+   
+   /** Wakes up the producers waiting for credits, to check their cancel flags. */
+   void FlowControl::wakeWaiters() {
+      {
+         // A waiter checks its flag under the lock, so it cannot miss this.
+         std::lock_guard<std::mutex> guard(flowGuard);
+      }
+      creditReturned.notify_all();
+   }
+   
+   void FlowControl::release() {
+      {
+         std::lock_guard<std::mutex> guard(flowGuard);
+         inFlight--;
+         inFlightGauge.set(static_cast<int64_t>(inFlight));
+      }
+      creditReturned.notify_one();
+   }
+   
+   std::size_t FlowControl::getInFlight() const {
+      std::lock_guard<std::mutex> guard(flowGuard);
+      return inFlight;
+   }
+   
+   std::size_t FlowControl::getHighWatermark() const {
+      return static_cast<std::size_t>(inFlightGauge.getHighWatermark());
+   }
+   
+   
+} //namespace
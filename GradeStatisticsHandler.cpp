@@ -0,0 +1,226 @@
+//
+//  GradeStatisticsHandler.cpp
+//  PipesAndFiltersFramework
+//
+//  Created by Antti Juustila on 19.10.2026.
+//  Copyright (c) 2026 Antti Juustila. All rights reserved.
+//
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <unordered_map>
+
+#include <g3log/g3log.hpp>
+
+#include <ProcessorNode/Package.h>
+
+#include <StudentNodeElements/GradeStatisticsHandler.h>
+#include <StudentNodeElements/StudentDataItem.h>
+#include <StudentNodeElements/MetricsRegistry.h>
+
+
+namespace OHARStudent {
+   
+   const std::string GradeStatisticsHandler::TAG{"GradeStatisticsHandler "};
+   
+   /** Handler ids are never reused, so a thread's accumulator is not mixed up with one of
+    a destroyed handler at the same address. */
+   static std::atomic<uint64_t> nextHandlerId{1};
+   
+   /**
+    Creates the handler.
+    @param fileName The file where the statistics snapshot is written, as JSON.
+    */
+   GradeStatisticsHandler::GradeStatisticsHandler(const std::string & fileName)
+   : fileName(fileName), handlerId(nextHandlerId++), metricsName(MetricsRegistry::get().instanceName("GradeStatisticsHandler")), allocationStage(metricsName)
+   {
+   }
+   
+   /** Writes the snapshot of the statistics. */
+   GradeStatisticsHandler::~GradeStatisticsHandler() {
+      writeSnapshot();
+   }
+   
+   /**
+    Adds a graded student to the statistics. A "flush" control package (end of batch) writes the snapshot.
+    @param data The package.
+    @returns False, so that the package is handled by the following handlers.
+    */
+   bool GradeStatisticsHandler::consume(OHARBase::Package & data) {
+      AllocationTag allocationTag(allocationStage);
+      if (data.getType() == OHARBase::Package::Data) {
+         const StudentDataItem * student = dynamic_cast<const StudentDataItem*>(data.getPayloadObject());
+         if (student) {
+            Accumulator & accumulator = threadAccumulator();
+            // Only contended while a snapshot is being taken.
+            std::lock_guard<std::mutex> guard(accumulator.guard);
+            accumulator.programs[student->getStudyProgram()].add(*student);
+         }
+      } else if (data.getType() == OHARBase::Package::Control) {
+         if (data.getPayloadString() == "flush") {
+            writeSnapshot();
+         }
+      }
+      return false;
+   }
+   
+   /** @returns The accumulator of the calling thread, created when the thread first passes a student. */
+   GradeStatisticsHandler::Accumulator & GradeStatisticsHandler::threadAccumulator() {
+      thread_local std::unordered_map<uint64_t, std::shared_ptr<Accumulator>> threadAccumulators;
+      std::shared_ptr<Accumulator> & accumulator = threadAccumulators[handlerId];
+      if (!accumulator) {
+         accumulator = std::make_shared<Accumulator>();
+         std::lock_guard<std::mutex> guard(accumulatorsGuard);
+         accumulators.push_back(accumulator);
+      }
+      return *accumulator;
+   }
+   
+   /**
+    Merges the accumulators of the threads into the current statistics.
+    @returns The statistics as JSON: the whole course in "course", and each study program in "programs".
+    */
+   nlohmann::json GradeStatisticsHandler::snapshot() const {
+      std::map<std::string, GroupStatistics> programs;
+      {
+         std::lock_guard<std::mutex> guard(accumulatorsGuard);
+         for (const std::shared_ptr<Accumulator> & accumulator : accumulators) {
+            std::lock_guard<std::mutex> accumulatorGuard(accumulator->guard);
+            for (const auto & program : accumulator->programs) {
+               programs[program.first].merge(program.second);
+            }
+         }
+      }
+      GroupStatistics course;
+      nlohmann::json programsJson = nlohmann::json::object();
+      for (const auto & program : programs) {
+         course.merge(program.second);
+         programsJson[program.first] = program.second.toJson();
+      }
+      return nlohmann::json{{"course", course.toJson()}, {"programs", programsJson}};
+   }
+   
+   /**
+    Writes the snapshot into the statistics file. The file is replaced atomically.
+    @returns True if the file was written.
+    */
+   bool GradeStatisticsHandler::writeSnapshot() const {
+      const std::string tempName = fileName + ".tmp";
+      std::ofstream file(tempName, std::ofstream::out | std::ofstream::trunc);
+      if (!file.is_open()) {
+         LOG(WARNING) << TAG << "Could not open statistics file " << tempName;
+         return false;
+      }
+      file << snapshot().dump(2) << '\n';
+      file.close();
+      if (!file || std::rename(tempName.c_str(), fileName.c_str()) != 0) {
+         LOG(WARNING) << TAG << "Could not write statistics file " << fileName;
+         return false;
+      }
+      LOG(INFO) << TAG << "Wrote grade statistics to " << fileName;
+      return true;
+   }
+   
+   /** Adds points, if the student has them (points are -1 when not known). */
+   void GradeStatisticsHandler::PointStatistics::add(int points) {
+      if (points < 0) {
+         return;
+      }
+      count++;
+      const double delta = points - mean;
+      mean += delta / count;
+      m2 += delta * (points - mean);
+      histogram[points]++;
+   }
+   
+   /** Merges statistics collected separately (Chan et al. parallel variance). */
+   void GradeStatisticsHandler::PointStatistics::merge(const PointStatistics & other) {
+      if (other.count == 0) {
+         return;
+      }
+      const uint64_t total = count + other.count;
+      const double delta = other.mean - mean;
+      m2 += other.m2 + delta * delta * (static_cast<double>(count) * other.count / total);
+      mean += delta * other.count / total;
+      count = total;
+      for (const auto & bucket : other.histogram) {
+         histogram[bucket.first] += bucket.second;
+      }
+   }
+   
+   nlohmann::json GradeStatisticsHandler::PointStatistics::toJson() const {
+      nlohmann::json json{{"count", count}};
+      if (count == 0) {
+         return json;
+      }
+      json["mean"] = mean;
+      json["variance"] = count > 1 ? m2 / (count - 1) : 0.0;
+      json["stddev"] = count > 1 ? std::sqrt(m2 / (count - 1)) : 0.0;
+      json["min"] = histogram.begin()->first;
+      json["max"] = histogram.rbegin()->first;
+      // Points are small integers, so the distribution is kept exactly and the quantiles are exact.
+      const std::pair<const char *, double> quantiles[] = {{"p25", 0.25}, {"p50", 0.5}, {"p75", 0.75}, {"p90", 0.9}};
+      for (const auto & quantile : quantiles) {
+         const uint64_t rank = static_cast<uint64_t>(std::ceil(quantile.second * count));
+         uint64_t seen = 0;
+         for (const auto & bucket : histogram) {
+            seen += bucket.second;
+            if (seen >= std::max<uint64_t>(rank, 1)) {
+               json[quantile.first] = bucket.first;
+               break;
+            }
+         }
+      }
+      return json;
+   }
+   
+   void GradeStatisticsHandler::GroupStatistics::add(const StudentDataItem & student) {
+      students++;
+      const int grade = student.getGrade();
+      if (grade >= 0 && grade < static_cast<int>(grades.size())) {
+         grades[grade]++;
+      } else {
+         ungraded++;
+      }
+      exam.add(student.getExamPoints());
+      if (!student.getExercisePoints().empty()) {
+         exercise.add(student.getExercisePointsTotal());
+      }
+      project.add(student.getCourseProjectPoints());
+   }
+   
+   void GradeStatisticsHandler::GroupStatistics::merge(const GroupStatistics & other) {
+      students += other.students;
+      for (std::size_t grade = 0; grade < grades.size(); grade++) {
+         grades[grade] += other.grades[grade];
+      }
+      ungraded += other.ungraded;
+      exam.merge(other.exam);
+      exercise.merge(other.exercise);
+      project.merge(other.project);
+   }
+   
+   nlohmann::json GradeStatisticsHandler::GroupStatistics::toJson() const {
+      nlohmann::json gradesJson = nlohmann::json::object();
+      uint64_t graded = 0;
+      for (std::size_t grade = 0; grade < grades.size(); grade++) {
+         gradesJson[std::to_string(grade)] = grades[grade];
+         graded += grades[grade];
+      }
+      const double passRate = graded > 0 ? static_cast<double>(graded - grades[0]) / graded : 0.0;
+      return nlohmann::json{
+         {"students", students},
+         {"grades", gradesJson},
+         {"ungraded", ungraded},
+         {"pass_rate", passRate},
+         {"exam", exam.toJson()},
+         {"exercise", exercise.toJson()},
+         {"project", project.toJson()}
+      };
+   }
+   
+   
+} //namespace
@@ -0,0 +1,174 @@
+//
+//  GradeStore.cpp
+//  PipesAndFiltersFramework
+//
+//  Created by Antti Juustila on 19.10.2026.
+//  Copyright (c) 2026 Antti Juustila. All rights reserved.
+//
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+#include <g3log/g3log.hpp>
+
+#include <StudentNodeElements/GradeStore.h>
+#include <StudentNodeElements/StudentDataItem.h>
+
+
+namespace OHARStudent {
+   
+   const std::string GradeStore::TAG{"GradeStore "};
+   
+   namespace {
+      const uint64_t FnvOffsetBasis = 0xcbf29ce484222325ULL;
+      const uint64_t FnvPrime = 0x100000001b3ULL;
+      
+      void hashBytes(uint64_t & hash, const void * data, std::size_t length) {
+         const unsigned char * bytes = static_cast<const unsigned char*>(data);
+         for (std::size_t index = 0; index < length; index++) {
+            hash ^= bytes[index];
+            hash *= FnvPrime;
+         }
+      }
+      
+      void hashInt(uint64_t & hash, int value) {
+         int32_t fixed = static_cast<int32_t>(value);
+         hashBytes(hash, &fixed, sizeof(fixed));
+      }
+   }
+   
+   /**
+    Creates the store, reading the grades from the file if it exists.
+    @param fileName The file where the grades are stored.
+    @param saveInterval How often the changed grades are saved into the file.
+    */
+   GradeStore::GradeStore(const std::string & fileName, std::chrono::milliseconds saveInterval)
+   : fileName(fileName), changed(false), saveInterval(saveInterval), running(true)
+   {
+      std::ifstream file(fileName);
+      if (file.is_open()) {
+         std::string line;
+         while (std::getline(file, line)) {
+            std::istringstream istr(line);
+            std::string id;
+            Entry entry;
+            if (std::getline(istr, id, '\t') && istr >> std::hex >> entry.inputHash >> std::dec >> entry.grade) {
+               entries[StudentKey(id)] = entry;
+            }
+         }
+         LOG(INFO) << TAG << "Read " << entries.size() << " stored grades from " << fileName;
+      } else {
+         LOG(INFO) << TAG << "No stored grades in " << fileName << ", grading all students.";
+      }
+      saverThread = std::thread(&GradeStore::run, this);
+   }
+   
+   /** Stops the saver thread and saves the store if grades were changed. */
+   GradeStore::~GradeStore() {
+      {
+         std::lock_guard<std::mutex> guard(storeGuard);
+         running = false;
+      }
+      wakeUp.notify_one();
+      if (saverThread.joinable()) {
+         saverThread.join();
+      }
+      save();
+   }
+   
+   /** The saver thread, saving the changed grades periodically until the store is destroyed. */
+   void GradeStore::run() {
+      std::unique_lock<std::mutex> lock(storeGuard);
+      while (running) {
+         wakeUp.wait_for(lock, saveInterval, [this] { return !running; });
+         if (running) {
+            lock.unlock();
+            save();
+            lock.lock();
+         }
+      }
+   }
+   
+   /**
+    Finds a stored grade for the student, if the student's data has not changed.
+    @param student The student to look for.
+    @param inputHash The hash of the student's current data, from inputHash().
+    @param grade Set to the stored grade, if found.
+    @returns True if the grade was found and the data has not changed since it was given.
+    */
+   bool GradeStore::findGrade(const StudentDataItem & student, uint64_t inputHash, int & grade) const {
+      std::lock_guard<std::mutex> guard(storeGuard);
+      auto iter = entries.find(student.getKey());
+      if (iter != entries.end() && iter->second.inputHash == inputHash) {
+         grade = iter->second.grade;
+         return true;
+      }
+      return false;
+   }
+   
+   /**
+    Stores the grade given to the student.
+    @param student The graded student.
+    @param inputHash The hash of the student's data the grade was calculated from.
+    @param grade The grade given.
+    */
+   void GradeStore::storeGrade(const StudentDataItem & student, uint64_t inputHash, int grade) {
+      std::lock_guard<std::mutex> guard(storeGuard);
+      entries[student.getKey()] = Entry{inputHash, grade};
+      changed = true;
+   }
+   
+   /** Writes the store into the file, if grades were changed. The grades are copied under the lock
+    and written without it, so grading continues meanwhile. The file is written next to the old one
+    and renamed over it, so an interrupted save leaves the old store intact. */
+   void GradeStore::save() {
+      std::lock_guard<std::mutex> saving(saveGuard);
+      std::vector<std::pair<StudentKey, Entry>> snapshot;
+      {
+         std::lock_guard<std::mutex> guard(storeGuard);
+         if (!changed) {
+            return;
+         }
+         snapshot.assign(entries.begin(), entries.end());
+         changed = false;
+      }
+      const std::string tempName = fileName + ".tmp";
+      std::ofstream file(tempName, std::ofstream::out | std::ofstream::trunc);
+      if (file.is_open()) {
+         for (const auto & entry : snapshot) {
+            file << entry.first.toString() << '\t' << std::hex << entry.second.inputHash << std::dec << '\t' << entry.second.grade << '\n';
+         }
+         file.close();
+      }
+      if (!file || std::rename(tempName.c_str(), fileName.c_str()) != 0) {
+         LOG(WARNING) << TAG << "Could not write the grade store " << fileName;
+         // Try again on the next save.
+         std::lock_guard<std::mutex> guard(storeGuard);
+         changed = true;
+      }
+   }
+   
+   /**
+    Calculates a hash of the student data the grade depends on, and the grader used.
+    If any of these change, the student must be graded again.
+    @param student The student to calculate the hash for.
+    @param graderName The name of the grader used.
+    @returns The hash value (64 bit FNV-1a).
+    */
+   uint64_t GradeStore::inputHash(const StudentDataItem & student, const std::string & graderName) {
+      uint64_t hash = FnvOffsetBasis;
+      hashBytes(hash, graderName.data(), graderName.length());
+      hashInt(hash, student.getExamPoints());
+      hashInt(hash, student.getCourseProjectPoints());
+      const std::vector<int> & exercisePoints = student.getExercisePoints();
+      hashInt(hash, static_cast<int>(exercisePoints.size()));
+      for (int points : exercisePoints) {
+         hashInt(hash, points);
+      }
+      return hash;
+   }
+   
+   
+} //namespace
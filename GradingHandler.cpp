@@ -12,6 +12,11 @@
 #include <ProcessorNode/Package.h>
 
 #include <StudentNodeElements/GraderFactory.h>
+#include <StudentNodeElements/GradeCalculator.h>
+#include <StudentNodeElements/GradeStore.h>
+#include <StudentNodeElements/MetricsRegistry.h>
+#include <StudentNodeElements/StudentTracer.h>
+#include <StudentNodeElements/PackageWorkerPool.h>
 #include <StudentNodeElements/GradingHandler.h>
 #include <StudentNodeElements/StudentDataItem.h>
 
@@ -24,34 +29,164 @@ namespace OHARStudent {
     using the help of the GraderFactory class.
     */
    GradingHandler::GradingHandler()
+   : poolPreservesOrder(true),
+   metricsName(MetricsRegistry::get().instanceName("GradingHandler")),
+   consumedCount(MetricsRegistry::get().counter(metricsName, "consumed")),
+   gradedCount(MetricsRegistry::get().counter(metricsName, "graded")),
+   unchangedCount(MetricsRegistry::get().counter(metricsName, "unchanged")),
+   consumeTime(MetricsRegistry::get().histogram(metricsName, "consume")),
+   allocationStage(metricsName)
    {
       // Uses the static student member variable and setter so that all students
       // use the same grade calculator. Equal grading for all students, eh?!
-      StudentDataItem::setGradeCalculator(GraderFactory::makeGrader());
+      policyVersion = StudentDataItem::setGradeCalculator(GraderFactory::makeGrader());
    }
 
    GradingHandler::~GradingHandler() {
-      StudentDataItem::setGradeCalculator(nullptr);
+      // Grade the students already in the pool before the calculator is removed.
+      workerPool.reset();
+      // Another handler may have published its grader since; that one is left in use.
+      StudentDataItem::removeGradeCalculator(policyVersion);
+   }
+   
+   /**
+    Replaces the grader used for all students, without stopping the grading. Students already
+    being graded finish with the previous grader; the ones graded after this get the new one.
+    @param grader The new grader.
+    @returns The version number of the new grading policy, recorded in the students it grades.
+    */
+   uint32_t GradingHandler::setGrader(std::shared_ptr<GradeCalculator> grader) {
+      const uint32_t version = StudentDataItem::setGradeCalculator(std::move(grader));
+      policyVersion = version;
+      return version;
    }
 
+   /**
+    Enables incremental grading. Grades given are stored in a file, with a hash of the student
+    data the grade was calculated from. In later runs, students whose data (and the grader) have
+    not changed get the stored grade without grading them again. They are still passed on, so
+    the report and the statistics include them; with the worker pool, they skip the pool and are
+    passed on right away (unless the pool preserves the order of the students).
+    @param fileName The file where the grades are stored.
+    @param saveInterval How often the grades are saved into the file while grading.
+    */
+   void GradingHandler::enableGradeStore(const std::string & fileName, std::chrono::milliseconds saveInterval) {
+      gradeStore = std::make_unique<GradeStore>(fileName, saveInterval);
+   }
+   
+   /**
+    Enables grading in a pool of worker threads. The thread delivering a student package
+    to consume (network or file reader thread) only queues the package and continues; the
+    workers grade the students and pass them to the handlers following this one.
+    @param node The node where this handler is, used to pass the graded students on.
+    @param workerCount The number of worker threads, zero for the number of hardware threads.
+    @param preserveOrder If true, students are passed on in the order they arrived. If false,
+    each student is passed on as soon as it has been graded.
+    */
+   void GradingHandler::enableWorkerPool(OHARBase::ProcessorNode & node, std::size_t workerCount, bool preserveOrder) {
+      workerPool = std::make_unique<PackageWorkerPool>(workerCount, preserveOrder,
+         [this] (OHARBase::Package & package) {
+            StudentDataItem * student = dynamic_cast<StudentDataItem*>(package.getPayloadObject());
+            if (student) {
+               grade(*student);
+            }
+            return true;
+         },
+         [this, &node] (OHARBase::Package & package) {
+            node.passToNextHandlers(this, package);
+         });
+      poolPreservesOrder = preserveOrder;
+      LOG(INFO) << TAG << "Grading in " << workerPool->getWorkerCount() << " worker threads.";
+   }
+   
    /** Grades the student based on the various course passing aspects, using the 
     selected grader algorithm.
     @param data The Package containing the student data.
     @returns Returns false, giving other handlers the opportunity to handle the package too.
+    If the worker pool is used, returns true for the students given to the pool, since the workers pass them on.
+    A "flush" control package (end of the batch) is passed on after the students in the pool.
     */
    bool GradingHandler::consume(OHARBase::Package & data) {
+      AllocationTag allocationTag(allocationStage);
       if (data.getType() == OHARBase::Package::Data) {
          OHARBase::DataItem * item = data.getPayloadObject();
          if (item) {
             StudentDataItem * student = dynamic_cast<StudentDataItem*>(item);
             if (student) {
-               LOG(INFO) << TAG << "Calculating a grade for the student " << student->getName();
-               student->calculateGrade();
+               if (workerPool) {
+                  if (gradeStore && !poolPreservesOrder) {
+                     // Unchanged students need no grading, so they need not wait in the pool either.
+                     GradingPolicyRef policy = StudentDataItem::getGradingPolicy();
+                     uint64_t inputHash = 0;
+                     if (policy && applyStoredGrade(*student, *policy, inputHash)) {
+                        consumedCount.add();
+                        return false;
+                     }
+                  }
+                  // Workers grade and pass the package on; keep the item in flight until then.
+                  workerPool->submit(std::move(data), FlowCredit::takeCurrent());
+                  return true;
+               }
+               grade(*student);
+               return false;
             }
          }
+      } else if (data.getType() == OHARBase::Package::Control) {
+         if (data.getPayloadString() == "flush" && workerPool) {
+            // End of the batch: the students still in the pool are passed on before it.
+            workerPool->drain();
+         }
       }
       return false; // Always let others handle this data package too.
    }
-
-
+   
+   /**
+    Grades one student, or takes the grade from the grade store if the student's data has not changed.
+    @param student The student to grade.
+    */
+   void GradingHandler::grade(StudentDataItem & student) {
+      // Also called in the worker threads.
+      AllocationTag allocationTag(allocationStage);
+      ScopedLatency timer(consumeTime);
+      TraceSpan span("grade", &student);
+      consumedCount.add();
+      // The same policy is used for the whole student, even if it is replaced meanwhile.
+      GradingPolicyRef policy = StudentDataItem::getGradingPolicy();
+      if (!policy) {
+         LOG(WARNING) << TAG << "No grader, passing on the student " << student.getId() << " ungraded.";
+         return;
+      }
+      uint64_t inputHash = 0;
+      if (gradeStore && applyStoredGrade(student, *policy, inputHash)) {
+         return;
+      }
+      LOG(INFO) << TAG << "Calculating a grade for the student " << student.getName();
+      student.calculateGrade(*policy);
+      gradedCount.add();
+      if (gradeStore) {
+         gradeStore->storeGrade(student, inputHash, student.getGrade());
+      }
+   }
+   
+   /**
+    Gives the student the grade from the grade store, if the student's data has not changed.
+    @param student The student.
+    @param policy The grading policy the stored grade must have been given with.
+    @param inputHash Set to the hash of the student's data, for storing a new grade.
+    @returns True if the stored grade was used.
+    */
+   bool GradingHandler::applyStoredGrade(StudentDataItem & student, const GradingPolicy & policy, uint64_t & inputHash) {
+      inputHash = GradeStore::inputHash(student, policy.name);
+      int storedGrade = -1;
+      if (!gradeStore->findGrade(student, inputHash, storedGrade)) {
+         return false;
+      }
+      LOG(INFO) << TAG << "Student data unchanged, using stored grade for " << student.getName();
+      student.setGrade(storedGrade);
+      student.setGradePolicyVersion(policy.version);
+      unchangedCount.add();
+      return true;
+   }
+   
+   
 } //namespace
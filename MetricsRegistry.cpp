@@ -0,0 +1,241 @@
+//
+//  MetricsRegistry.cpp
+//  PipesAndFiltersFramework
+//
+//  Created by Antti Juustila on 19.10.2026.
+//  Copyright (c) 2026 Antti Juustila. All rights reserved.
+//
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+
+#include <g3log/g3log.hpp>
+
+#include <StudentNodeElements/MetricsRegistry.h>
+
+
+namespace OHARStudent {
+   
+   const std::string MetricsRegistry::TAG{"Metrics "};
+   
+   void MetricGauge::set(int64_t newValue) {
+      value.store(newValue, std::memory_order_relaxed);
+      updateHighWatermark(newValue);
+   }
+   
+   void MetricGauge::add(int64_t amount) {
+      updateHighWatermark(value.fetch_add(amount, std::memory_order_relaxed) + amount);
+   }
+   
+   void MetricGauge::updateHighWatermark(int64_t newValue) {
+      int64_t current = highWatermark.load(std::memory_order_relaxed);
+      while (newValue > current && !highWatermark.compare_exchange_weak(current, newValue, std::memory_order_relaxed)) {
+      }
+   }
+   
+   MetricHistogram::MetricHistogram()
+   : count(0), sum(0), max(0)
+   {
+      for (auto & bucket : buckets) {
+         bucket.store(0, std::memory_order_relaxed);
+      }
+   }
+   
+   /** Records one duration into the histogram.
+    @param duration The duration to record. */
+   void MetricHistogram::record(std::chrono::nanoseconds duration) {
+      uint64_t nanos = duration.count() > 0 ? static_cast<uint64_t>(duration.count()) : 0;
+      // Bucket n holds values below 2^n nanoseconds.
+      int bucket = 0;
+      while (bucket < BucketCount - 1 && (nanos >> bucket) != 0) {
+         bucket++;
+      }
+      buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+      count.fetch_add(1, std::memory_order_relaxed);
+      sum.fetch_add(nanos, std::memory_order_relaxed);
+      uint64_t currentMax = max.load(std::memory_order_relaxed);
+      while (nanos > currentMax && !max.compare_exchange_weak(currentMax, nanos, std::memory_order_relaxed)) {
+      }
+   }
+   
+   /** Estimates a percentile of the recorded durations.
+    @param fraction The percentile as a fraction, e.g. 0.99.
+    @returns The upper bound (nanoseconds) of the bucket where the percentile is. */
+   uint64_t MetricHistogram::percentile(double fraction) const {
+      uint64_t total = getCount();
+      if (total == 0) {
+         return 0;
+      }
+      uint64_t target = static_cast<uint64_t>(fraction * total);
+      uint64_t seen = 0;
+      for (int bucket = 0; bucket < BucketCount; bucket++) {
+         seen += buckets[bucket].load(std::memory_order_relaxed);
+         if (seen > target) {
+            uint64_t upperBound = bucket == 0 ? 0 : (uint64_t(1) << bucket) - 1;
+            return std::min(upperBound, max.load(std::memory_order_relaxed));
+         }
+      }
+      return max.load(std::memory_order_relaxed);
+   }
+   
+   nlohmann::json MetricHistogram::toJson() const {
+      uint64_t total = getCount();
+      uint64_t totalNanos = sum.load(std::memory_order_relaxed);
+      return nlohmann::json{
+         {"count", total},
+         {"sum_ns", totalNanos},
+         {"mean_ns", total > 0 ? totalNanos / total : 0},
+         {"p50_ns", percentile(0.50)},
+         {"p90_ns", percentile(0.90)},
+         {"p99_ns", percentile(0.99)},
+         {"max_ns", max.load(std::memory_order_relaxed)}
+      };
+   }
+   
+   MetricsRegistry::MetricsRegistry()
+   : dumping(false)
+   {
+   }
+   
+   MetricsRegistry::~MetricsRegistry() {
+      stopDumping();
+   }
+   
+   /** @returns The registry of the metrics in this process. */
+   MetricsRegistry & MetricsRegistry::get() {
+      static MetricsRegistry registry;
+      return registry;
+   }
+   
+   /**
+    Names a new handler instance for its metrics. The first instance of a handler class gets
+    the class name as such, the following ones a running number: "GradingHandler",
+    "GradingHandler#2" and so on.
+    @param handler The name of the handler class.
+    @returns The name to register the metrics of the instance with.
+    */
+   std::string MetricsRegistry::instanceName(const std::string & handler) {
+      std::lock_guard<std::mutex> guard(registryGuard);
+      const unsigned instance = ++instanceCounts[handler];
+      return instance == 1 ? handler : handler + "#" + std::to_string(instance);
+   }
+   
+   /** Gets a counter, creating it if it does not exist yet. The returned reference
+    stays valid for the lifetime of the process.
+    @param handler The name of the handler the metric belongs to.
+    @param name The name of the metric.
+    @returns The counter. */
+   MetricCounter & MetricsRegistry::counter(const std::string & handler, const std::string & name) {
+      std::lock_guard<std::mutex> guard(registryGuard);
+      std::unique_ptr<MetricCounter> & metric = handlers[handler].counters[name];
+      if (!metric) {
+         metric = std::make_unique<MetricCounter>();
+      }
+      return *metric;
+   }
+   
+   /** Gets a gauge, creating it if it does not exist yet.
+    @param handler The name of the handler the metric belongs to.
+    @param name The name of the metric.
+    @returns The gauge. */
+   MetricGauge & MetricsRegistry::gauge(const std::string & handler, const std::string & name) {
+      std::lock_guard<std::mutex> guard(registryGuard);
+      std::unique_ptr<MetricGauge> & metric = handlers[handler].gauges[name];
+      if (!metric) {
+         metric = std::make_unique<MetricGauge>();
+      }
+      return *metric;
+   }
+   
+   /** Gets a histogram, creating it if it does not exist yet.
+    @param handler The name of the handler the metric belongs to.
+    @param name The name of the metric.
+    @returns The histogram. */
+   MetricHistogram & MetricsRegistry::histogram(const std::string & handler, const std::string & name) {
+      std::lock_guard<std::mutex> guard(registryGuard);
+      std::unique_ptr<MetricHistogram> & metric = handlers[handler].histograms[name];
+      if (!metric) {
+         metric = std::make_unique<MetricHistogram>();
+      }
+      return *metric;
+   }
+   
+   /** Reads the current values of all the metrics.
+    @returns A JSON object with the metrics of each handler. */
+   nlohmann::json MetricsRegistry::snapshot() const {
+      nlohmann::json handlersJson = nlohmann::json::object();
+      std::lock_guard<std::mutex> guard(registryGuard);
+      for (const auto & handler : handlers) {
+         nlohmann::json metrics = nlohmann::json::object();
+         for (const auto & metric : handler.second.counters) {
+            metrics["counters"][metric.first] = metric.second->get();
+         }
+         for (const auto & metric : handler.second.gauges) {
+            metrics["gauges"][metric.first] = nlohmann::json{{"value", metric.second->get()}, {"high", metric.second->getHighWatermark()}};
+         }
+         for (const auto & metric : handler.second.histograms) {
+            metrics["histograms"][metric.first] = metric.second->toJson();
+         }
+         handlersJson[handler.first] = metrics;
+      }
+      auto now = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch());
+      return nlohmann::json{{"timestamp_ms", now.count()}, {"handlers", handlersJson}};
+   }
+   
+   /** Writes a snapshot of the metrics into a JSON file. The file is replaced
+    atomically, so readers never see a partially written file.
+    @param fileName The file to write to.
+    @returns True if the file was written. */
+   bool MetricsRegistry::dump(const std::string & fileName) const {
+      const std::string tempName = fileName + ".tmp";
+      std::ofstream file(tempName, std::ofstream::out | std::ofstream::trunc);
+      if (!file.is_open()) {
+         LOG(WARNING) << TAG << "Could not open metrics file " << tempName;
+         return false;
+      }
+      file << snapshot().dump(2) << '\n';
+      file.close();
+      if (!file) {
+         // E.g. the disk is full; keep the previous metrics file rather than a truncated one.
+         LOG(WARNING) << TAG << "Could not write metrics file " << tempName;
+         std::remove(tempName.c_str());
+         return false;
+      }
+      if (std::rename(tempName.c_str(), fileName.c_str()) != 0) {
+         LOG(WARNING) << TAG << "Could not replace metrics file " << fileName;
+         std::remove(tempName.c_str());
+         return false;
+      }
+      return true;
+   }
+   
+   /** Starts a thread writing the metrics into a file periodically.
+    @param fileName The file to write to.
+    @param interval How often the file is written. */
+   void MetricsRegistry::startDumping(const std::string & fileName, std::chrono::milliseconds interval) {
+      stopDumping();
+      dumping = true;
+      dumpThread = std::thread([this, fileName, interval] {
+         std::unique_lock<std::mutex> lock(dumpGuard);
+         while (dumping) {
+            dumpWakeUp.wait_for(lock, interval, [this] { return !dumping; });
+            dump(fileName);
+         }
+      });
+   }
+   
+   /** Stops the periodic dumping of the metrics, if started. */
+   void MetricsRegistry::stopDumping() {
+      {
+         std::lock_guard<std::mutex> guard(dumpGuard);
+         dumping = false;
+      }
+      dumpWakeUp.notify_one();
+      if (dumpThread.joinable()) {
+         dumpThread.join();
+      }
+   }
+   
+   
+} //namespace
@@ -0,0 +1,153 @@
+//
+//  PackageWorkerPool.cpp
+//  PipesAndFiltersFramework
+//
+//  Created by Antti Juustila on 19.10.2026.
+//  Copyright (c) 2026 Antti Juustila. All rights reserved.
+//
+
+#include <algorithm>
+
+#include <StudentNodeElements/PackageWorkerPool.h>
+
+
+namespace OHARStudent {
+   
+   /**
+    Creates the pool and starts the worker threads.
+    @param workerCount Number of worker threads; zero uses the number of hardware threads.
+    @param preserveOrder If true, packages are emitted in the order they were submitted.
+    @param work The function handling a package.
+    @param emit The function called for each handled package.
+    */
+   PackageWorkerPool::PackageWorkerPool(std::size_t workerCount, bool preserveOrder, Work work, Emit emit)
+   : work(work), emit(emit), preserveOrder(preserveOrder), nextSequence(0), nextQueue(0),
+   queued(0), unfinished(0), stopping(false), nextToEmit(0)
+   {
+      if (workerCount == 0) {
+         workerCount = std::max(1u, std::thread::hardware_concurrency());
+      }
+      for (std::size_t index = 0; index < workerCount; index++) {
+         queues.push_back(std::make_unique<WorkerQueue>());
+      }
+      for (std::size_t index = 0; index < workerCount; index++) {
+         threads.emplace_back(&PackageWorkerPool::run, this, index);
+      }
+   }
+   
+   /** Handles the packages already submitted and stops the workers. */
+   PackageWorkerPool::~PackageWorkerPool() {
+      drain();
+      {
+         std::lock_guard<std::mutex> guard(stateGuard);
+         stopping = true;
+      }
+      workAvailable.notify_all();
+      for (std::thread & thread : threads) {
+         thread.join();
+      }
+   }
+   
+   /**
+    Submits a package to be handled by the workers.
+    @param package The package, moved into the pool.
+    @param credit The flow control credit of the package, if any, returned when the package has been emitted.
+    */
+   void PackageWorkerPool::submit(OHARBase::Package && package, FlowCredit credit) {
+      Job job{0, true, std::move(package), std::move(credit)};
+      std::size_t queueIndex = nextQueue.fetch_add(1, std::memory_order_relaxed) % queues.size();
+      {
+         std::lock_guard<std::mutex> guard(stateGuard);
+         queued++;
+         unfinished++;
+      }
+      {
+         // The sequence is taken while holding the queue lock, so each queue is in sequence order.
+         std::lock_guard<std::mutex> guard(queues[queueIndex]->queueGuard);
+         job.sequence = nextSequence.fetch_add(1);
+         queues[queueIndex]->jobs.push_back(std::move(job));
+      }
+      workAvailable.notify_one();
+   }
+   
+   /** Waits until all submitted packages have been handled and emitted. */
+   void PackageWorkerPool::drain() {
+      std::unique_lock<std::mutex> lock(stateGuard);
+      allDone.wait(lock, [this] { return unfinished == 0; });
+   }
+   
+   std::size_t PackageWorkerPool::getWorkerCount() const {
+      return threads.size();
+   }
+   
+   void PackageWorkerPool::run(std::size_t workerIndex) {
+      while (true) {
+         {
+            std::unique_lock<std::mutex> lock(stateGuard);
+            workAvailable.wait(lock, [this] { return stopping || queued > 0; });
+            if (queued == 0 && stopping) {
+               return;
+            }
+         }
+         Job job;
+         if (takeJob(workerIndex, job)) {
+            job.emit = work(job.package);
+            finish(std::move(job));
+         }
+      }
+   }
+   
+   /** Takes a job from the worker's own queue, or steals one from the other queues. */
+   bool PackageWorkerPool::takeJob(std::size_t workerIndex, Job & job) {
+      for (std::size_t offset = 0; offset < queues.size(); offset++) {
+         WorkerQueue & queue = *queues[(workerIndex + offset) % queues.size()];
+         std::lock_guard<std::mutex> guard(queue.queueGuard);
+         if (!queue.jobs.empty()) {
+            if (offset == 0) {
+               job = std::move(queue.jobs.front());
+               queue.jobs.pop_front();
+            } else {
+               job = std::move(queue.jobs.back());
+               queue.jobs.pop_back();
+            }
+            std::lock_guard<std::mutex> stateLock(stateGuard);
+            queued--;
+            return true;
+         }
+      }
+      return false;
+   }
+   
+   /** Emits the handled job, in order if required, and releases its credit. */
+   void PackageWorkerPool::finish(Job && job) {
+      std::size_t finished = 0;
+      if (preserveOrder) {
+         std::lock_guard<std::mutex> guard(orderGuard);
+         waitingToEmit.emplace(job.sequence, std::move(job));
+         // Emitting while holding the lock keeps the following handlers in order too.
+         for (auto iter = waitingToEmit.begin(); iter != waitingToEmit.end() && iter->first == nextToEmit; iter = waitingToEmit.erase(iter)) {
+            if (iter->second.emit) {
+               emit(iter->second.package);
+            }
+            iter->second.credit.release();
+            nextToEmit++;
+            finished++;
+         }
+      } else {
+         if (job.emit) {
+            emit(job.package);
+         }
+         job.credit.release();
+         finished = 1;
+      }
+      if (finished > 0) {
+         std::lock_guard<std::mutex> guard(stateGuard);
+         unfinished -= finished;
+         if (unfinished == 0) {
+            allDone.notify_all();
+         }
+      }
+   }
+   
+   
+} //namespace
@@ -17,6 +17,9 @@
 #include <StudentNodeElements/PlainStudentFileHandler.h>
 #include <StudentNodeElements/StudentDataItem.h>
 #include <StudentNodeElements/StudentFileReader.h>
+#include <StudentNodeElements/StudentFileSet.h>
+#include <StudentNodeElements/ReaderExecutor.h>
+#include <StudentNodeElements/MetricsRegistry.h>
 
 
 namespace OHARStudent {
@@ -24,8 +27,11 @@ namespace OHARStudent {
    const std::string PlainStudentFileHandler::TAG{"SPlainFileHandler "};
    
    PlainStudentFileHandler::PlainStudentFileHandler(OHARBase::ProcessorNode & myNode)
-   : node(myNode)
+   : node(myNode), metricsName(MetricsRegistry::get().instanceName("PlainStudentFileHandler")), readerFlow(metricsName), maxParallelFiles(4), followFiles(false), lazyParsing(false),
+   readingBatch(false), previousNodeEnded(false), allocationStage(metricsName), reader(TAG)
    {
+      // Cancelling the reading wakes up the reader thread waiting for flow control credits.
+      reader.setCancelListener([this] { readerFlow.wakeWaiters(); });
    }
    
    PlainStudentFileHandler::~PlainStudentFileHandler() {
@@ -33,48 +39,163 @@ namespace OHARStudent {
    }
    
    /** Uses a StudentFileReader for reading student data from a file.
-    File name is acquired from the ProcessorNode configuration. */
+    File name is acquired from the ProcessorNode configuration. The configuration item may also
+    list several files or glob patterns, separated by commas (see StudentFileSet). */
    void PlainStudentFileHandler::readFile() {
       // Why read the file in a thread? When readfile control Package arrives from the previous Node,
       // and this node starts handling the command, the control / command handling is executed
       // in the context of the incomingHandlerThread -- effectively stopping the handling of other
       // packages waiting in the network interface, until file is read. Or, if the command is executed in the context of
       // command handler thread, then other commands cannot be handled until file has been read -- if the
-      // file to read is very large, this could take seconds/tens of seconds. So, start a new thread when the file
-      // is read, to let the other thread continue the work it needs to do.
-      // This would be an issue only with very large files, so if optimization would be required, change the code below
-      // so that first, check the size of the file and if it is small then execute file reading without a thread.
-      // If it is large, then do as below, read the file in a thread.
-      std::thread( [this] {
-         StudentFileReader reader(*this);
-         using namespace std::chrono_literals;
-         std::this_thread::sleep_for(50ms);
-         reader.read(node.getDataFileName());
-      }).detach();
+      // file to read is very large, this could take seconds/tens of seconds. So, the file is read in the
+      // reader executor thread owned by this handler, to let the other thread continue the work it needs to do.
+      // The executor starts reading when consume has finished handling the command, and ignores the
+      // request if the file is already being read.
+      // The data file configuration may list several files (or glob patterns); those are read
+      // concurrently, at most maxParallelFiles at the same time.
+      // In follow mode the files are read and then followed, passing on rows appended to them,
+      // until reading is cancelled. Readfile commands arriving meanwhile are then ignored.
+      const std::size_t parallelFiles = maxParallelFiles;
+      const bool follow = followFiles;
+      const bool lazy = lazyParsing;
+      // Set before the reading starts, so that a "flush" following the command is held back.
+      bool wasReading = false;
+      if (!follow) {
+         std::lock_guard<std::mutex> guard(batchGuard);
+         wasReading = readingBatch;
+         readingBatch = true;
+      }
+      const bool accepted = reader.submit( [this, parallelFiles, follow, lazy] (const std::atomic<bool> & cancelled) {
+         std::vector<std::string> files = StudentFileSet::expand(node.getDataFileName());
+         if (follow) {
+            StudentFileSet::followAll(*this, files, cancelled, lazy);
+         } else {
+            StudentFileSet::readAll(*this, files, parallelFiles, &cancelled, lazy);
+            bool endOfBatch = !cancelled;
+            {
+               std::lock_guard<std::mutex> guard(batchGuard);
+               // The end of the batch of the previous node, held back while reading, ends this one too.
+               endOfBatch = endOfBatch || previousNodeEnded;
+               readingBatch = false;
+               previousNodeEnded = false;
+            }
+            if (endOfBatch) {
+               passEndOfBatch();
+            }
+         }
+      });
+      if (!accepted && !follow && !wasReading) {
+         // The files are being followed, there is no batch to end.
+         std::lock_guard<std::mutex> guard(batchGuard);
+         readingBatch = false;
+      }
+   }
+   
+   /**
+    Passes a "flush" control package to the next handlers when the data files have been read,
+    telling the handlers collecting students (e.g. StudentOrderingHandler) that the batch has ended.
+    A "flush" arriving from a previous node while the files are read is passed on only here, so
+    that it does not overtake the students read from the files.
+    */
+   void PlainStudentFileHandler::passEndOfBatch() {
+      LOG(INFO) << TAG << "Data files read, passing on the end of the batch.";
+      OHARBase::Package endOfBatch;
+      endOfBatch.setType(OHARBase::Package::Control);
+      endOfBatch.setPayload(std::string("flush"));
+      node.passToNextHandlers(this, endOfBatch);
    }
    
    /**
     Checks if the package contains a control message indicating that
     a data file should be read. If yes, reads the data using readFile().
     @param data The package message indicating what to do.
-    @returns Returns always false, pass the package to next handler.
+    @returns Returns false, pass the package to next handler, except for a "flush" held back
+    until the files have been read.
     */
    bool PlainStudentFileHandler::consume(OHARBase::Package & data) {
+      AllocationTag allocationTag(allocationStage);
       if (data.getType() == OHARBase::Package::Control) {
          if (data.getPayloadString() == "readfile") {
+            ReaderExecutor::ReadyGate readyWhenHandled(reader);
             readFile();
+         } else if (data.getPayloadString() == "flush") {
+            std::lock_guard<std::mutex> guard(batchGuard);
+            if (readingBatch) {
+               previousNodeEnded = true;
+               return true;
+            }
          }
       }
       return false; // false: pass to next handler. true: do not pass to next handler.
    }
    
+   /**
+    Sets how many data files are read at the same time, when the data file configuration
+    of the node lists several files.
+    @param maxFiles The maximum number of files read concurrently.
+    */
+   void PlainStudentFileHandler::setMaxParallelFiles(std::size_t maxFiles) {
+      maxParallelFiles = maxFiles;
+   }
+   
+   /**
+    Sets the follow mode. In follow mode, the data files are not read just once, but
+    followed like "tail -f": rows appended to the files are read and passed on as they
+    are written, until cancelFileRead is called or the handler is destroyed.
+    @param follow True to follow the data files.
+    */
+   void PlainStudentFileHandler::setFollowMode(bool follow) {
+      followFiles = follow;
+   }
+   
+   /**
+    Sets lazy parsing on or off. With lazy parsing, only the student id is parsed when the
+    files are read, and the other values when a following handler first needs them. A node
+    just passing the students on (e.g. to the network) then skips most of the parsing.
+    @param lazy True to parse lazily.
+    */
+   void PlainStudentFileHandler::setLazyParsing(bool lazy) {
+      lazyParsing = lazy;
+   }
+   
+   /**
+    Waits until the data file has been read, if reading is pending or going on.
+    @param timeout How long to wait at most.
+    @returns True if the file is not being read anymore.
+    */
+   bool PlainStudentFileHandler::waitForFileRead(std::chrono::milliseconds timeout) {
+      return reader.waitForCompletion(timeout);
+   }
+   
+   /** Cancels reading the data file, if reading is pending or going on. */
+   void PlainStudentFileHandler::cancelFileRead() {
+      reader.cancel();
+   }
+   
+   /**
+    Sets the maximum number of items read from the data file which can be in flight in
+    the following handlers. When the limit is reached, the file reading thread waits until
+    items have been handled. By default the reading is not limited.
+    @param maxItems The maximum number of items in flight, zero for no limit.
+    */
+   void PlainStudentFileHandler::setMaxItemsInFlight(std::size_t maxItems) {
+      readerFlow.setMaxInFlight(maxItems);
+   }
+   
    /** This method is called by the StudentFileReader when the new data item has
     been read from the data file. The student object is then placed in a Package
     and passed on to the next DataHandler in the ProcessorNode.
     @param item The new student data item read from the file.
     */
    void PlainStudentFileHandler::handleNewItem(std::unique_ptr<OHARBase::DataItem> item) {
-      // Check if the item is already in the container.
+      AllocationTag allocationTag(allocationStage);
+      // Wait until there is room downstream for one more item, or reading is cancelled.
+      FlowCredit credit = readerFlow.acquire(&reader.getCancelFlag());
+      if (!credit.isValid()) {
+         LOG(INFO) << TAG << "Reading cancelled, item dropped.";
+         return;
+      }
+      FlowCredit::Scope creditScope(credit);
       LOG(INFO) << TAG << "One new file data item received";
       StudentDataItem * newStudent = dynamic_cast<StudentDataItem*>(item.get());
       if (newStudent) {
@@ -0,0 +1,136 @@
+//
+//  ReaderExecutor.cpp
+//  PipesAndFiltersFramework
+//
+//  Created by Antti Juustila on 19.10.2026.
+//  Copyright (c) 2026 Antti Juustila. All rights reserved.
+//
+
+#include <g3log/g3log.hpp>
+
+#include <StudentNodeElements/ReaderExecutor.h>
+
+
+namespace OHARStudent {
+   
+   /**
+    Creates the executor. The worker thread is started when the first task is submitted.
+    @param name The name of the executor, used in logging.
+    */
+   ReaderExecutor::ReaderExecutor(const std::string & name)
+   : name(name), busy(false), ready(false), stopping(false), cancelled(false)
+   {
+   }
+   
+   /** Cancels a running task and waits for the worker thread to end. */
+   ReaderExecutor::~ReaderExecutor() {
+      {
+         std::lock_guard<std::mutex> guard(executorGuard);
+         stopping = true;
+         cancelled = true;
+      }
+      stateChanged.notify_all();
+      if (cancelListener) {
+         cancelListener();
+      }
+      if (worker.joinable()) {
+         worker.join();
+      }
+   }
+   
+   /**
+    Submits a read task, unless a task is already pending or running.
+    @param task The task to execute.
+    @returns True if the task was accepted, false if it was ignored as a duplicate.
+    */
+   bool ReaderExecutor::submit(Task task) {
+      std::lock_guard<std::mutex> guard(executorGuard);
+      if (busy) {
+         LOG(INFO) << name << " already reading, ignoring the new read request.";
+         return false;
+      }
+      pendingTask = std::move(task);
+      busy = true;
+      ready = false;
+      cancelled = false;
+      if (!worker.joinable()) {
+         worker = std::thread(&ReaderExecutor::run, this);
+      }
+      stateChanged.notify_all();
+      return true;
+   }
+   
+   /** Lets a submitted task start. */
+   void ReaderExecutor::markReady() {
+      {
+         std::lock_guard<std::mutex> guard(executorGuard);
+         ready = true;
+      }
+      stateChanged.notify_all();
+   }
+   
+   /** Asks a pending or running task to stop. A pending task is not started at all. */
+   void ReaderExecutor::cancel() {
+      {
+         std::lock_guard<std::mutex> guard(executorGuard);
+         cancelled = true;
+      }
+      stateChanged.notify_all();
+      if (cancelListener) {
+         cancelListener();
+      }
+   }
+   
+   /**
+    Sets the function called when a task is cancelled, after the cancel flag has been set.
+    Set it before submitting tasks.
+    @param listener The function, e.g. waking up the task waiting for flow control credits.
+    */
+   void ReaderExecutor::setCancelListener(CancelListener listener) {
+      cancelListener = std::move(listener);
+   }
+   
+   /** @returns The cancel flag of the current task, for the code the task calls. */
+   const std::atomic<bool> & ReaderExecutor::getCancelFlag() const {
+      return cancelled;
+   }
+   
+   /** @returns True if a task is pending or running. */
+   bool ReaderExecutor::isBusy() const {
+      std::lock_guard<std::mutex> guard(executorGuard);
+      return busy;
+   }
+   
+   /**
+    Waits until the pending or running task has finished.
+    @param timeout How long to wait at most.
+    @returns True if no task is pending or running anymore.
+    */
+   bool ReaderExecutor::waitForCompletion(std::chrono::milliseconds timeout) {
+      std::unique_lock<std::mutex> lock(executorGuard);
+      return stateChanged.wait_for(lock, timeout, [this] { return !busy; });
+   }
+   
+   void ReaderExecutor::run() {
+      std::unique_lock<std::mutex> lock(executorGuard);
+      while (!stopping) {
+         stateChanged.wait(lock, [this] { return stopping || (busy && (ready || cancelled)); });
+         if (stopping) {
+            break;
+         }
+         Task task = std::move(pendingTask);
+         pendingTask = nullptr;
+         if (!cancelled && task) {
+            lock.unlock();
+            task(cancelled);
+            lock.lock();
+         }
+         busy = false;
+         stateChanged.notify_all();
+      }
+      busy = false;
+      stateChanged.notify_all();
+   }
+   
+   
+} //namespace
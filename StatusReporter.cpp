@@ -0,0 +1,106 @@
+//
+//  StatusReporter.cpp
+//  PipesAndFiltersFramework
+//
+//  Created by Antti Juustila on 19.10.2026.
+//  Copyright (c) 2026 Antti Juustila. All rights reserved.
+//
+
+#include <algorithm>
+
+#include <ProcessorNode/ProcessorNode.h>
+
+#include <StudentNodeElements/StatusReporter.h>
+
+
+namespace OHARStudent {
+   
+   /**
+    Creates the reporter.
+    @param node The node whose UI gets the updates.
+    @param handlerName The name of the handler shown in the UI messages.
+    @param queueName The name of the queue whose count is updated with the held students, empty for none.
+    @param maxUpdatesPerSecond The maximum number of updates published per second.
+    */
+   StatusReporter::StatusReporter(OHARBase::ProcessorNode & node, const std::string & handlerName, const std::string & queueName, unsigned maxUpdatesPerSecond)
+   : node(node), handlerName(handlerName), queueName(queueName),
+   minInterval(0), lastPublished(0), receivedCount(0), mergedCount(0), writtenCount(0), heldCount(0), changed(false)
+   {
+      setMaxUpdatesPerSecond(maxUpdatesPerSecond);
+   }
+   
+   /** Sets how many updates are published per second at most.
+    @param maxUpdatesPerSecond The maximum number of updates per second. */
+   void StatusReporter::setMaxUpdatesPerSecond(unsigned maxUpdatesPerSecond) {
+      const std::chrono::steady_clock::duration interval = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::seconds(1)) / std::max(1u, maxUpdatesPerSecond);
+      minInterval.store(interval.count(), std::memory_order_relaxed);
+   }
+   
+   /** Counts a student received by the handler. */
+   void StatusReporter::received() {
+      receivedCount.fetch_add(1, std::memory_order_relaxed);
+      changed.store(true, std::memory_order_relaxed);
+   }
+   
+   /** Counts a student merged with data held by the handler. */
+   void StatusReporter::merged() {
+      mergedCount.fetch_add(1, std::memory_order_relaxed);
+      changed.store(true, std::memory_order_relaxed);
+   }
+   
+   /** Counts a student written by the handler. */
+   void StatusReporter::written() {
+      writtenCount.fetch_add(1, std::memory_order_relaxed);
+      changed.store(true, std::memory_order_relaxed);
+   }
+   
+   /** Sets the number of students the handler holds now.
+    @param count The number of students held. */
+   void StatusReporter::setHeld(std::size_t count) {
+      heldCount.store(count, std::memory_order_relaxed);
+      changed.store(true, std::memory_order_relaxed);
+   }
+   
+   /** Publishes an update if something has changed and enough time has passed since the
+    previous update. Call this without holding locks, since the node's UI is updated. */
+   void StatusReporter::publishIfDue() {
+      if (!changed.load(std::memory_order_relaxed)) {
+         return;
+      }
+      std::chrono::steady_clock::rep now = std::chrono::steady_clock::now().time_since_epoch().count();
+      std::chrono::steady_clock::rep previous = lastPublished.load(std::memory_order_relaxed);
+      if (now - previous < minInterval.load(std::memory_order_relaxed)) {
+         return;
+      }
+      // Only the thread winning the race publishes this update.
+      if (lastPublished.compare_exchange_strong(previous, now, std::memory_order_relaxed)) {
+         publish();
+      }
+   }
+   
+   /** Publishes an update now, e.g. when the handler has finished reading a file so that the
+    final counts are shown. */
+   void StatusReporter::publish() {
+      changed.store(false, std::memory_order_relaxed);
+      const std::size_t held = heldCount.load(std::memory_order_relaxed);
+      std::string message = handlerName + ": received " + std::to_string(receivedCount.load(std::memory_order_relaxed));
+      const uint64_t mergedSoFar = mergedCount.load(std::memory_order_relaxed);
+      if (mergedSoFar > 0) {
+         message += ", merged " + std::to_string(mergedSoFar);
+      }
+      const uint64_t writtenSoFar = writtenCount.load(std::memory_order_relaxed);
+      if (writtenSoFar > 0) {
+         message += ", written " + std::to_string(writtenSoFar);
+      }
+      if (!queueName.empty()) {
+         message += ", holding " + std::to_string(held);
+      }
+      message += " students.";
+      node.showUIMessage(message);
+      if (!queueName.empty()) {
+         node.updatePackageCountInQueue(queueName, held);
+      }
+   }
+   
+   
+} //namespace
@@ -0,0 +1,230 @@
+//
+//  StudentCheckpointer.cpp
+//  PipesAndFiltersFramework
+//
+//  Created by Antti Juustila on 19.10.2026.
+//  Copyright (c) 2026 Antti Juustila. All rights reserved.
+//
+
+#include <cstdio>
+#include <stdexcept>
+
+#include <g3log/g3log.hpp>
+
+#include <nlohmann/json.hpp>
+
+#include <StudentNodeElements/StudentCheckpointer.h>
+#include <StudentNodeElements/StudentDataItem.h>
+
+
+namespace OHARStudent {
+   
+   const std::string StudentCheckpointer::Magic{"SNECKPT2"};
+   const std::string StudentCheckpointer::MagicV1{"SNECKPT1"};
+   const std::string StudentCheckpointer::TAG{"SCheckpointer "};
+   
+   /**
+    Creates the checkpointer. Nothing is read or written before restore() and start() are called.
+    @param fileName The snapshot file to restore from and write to.
+    @param interval How often pending changes are written to the file.
+    */
+   StudentCheckpointer::StudentCheckpointer(const std::string & fileName, std::chrono::milliseconds interval)
+   : fileName(fileName), interval(interval), running(false), recordsInFile(0)
+   {
+   }
+   
+   /** Stops the writer thread, writing the changes still pending. */
+   StudentCheckpointer::~StudentCheckpointer() {
+      stop();
+   }
+   
+   /**
+    Reads the students from the snapshot file, replaying the held and released records in order.
+    A truncated record at the end of the file (node stopped in the middle of a write) is ignored.
+    @returns The students which were held by the handler when the last checkpoint was written,
+    with their sources.
+    */
+   std::vector<StudentCheckpointer::Restored> StudentCheckpointer::restore() {
+      std::vector<Restored> students;
+      written.clear();
+      recordsInFile = 0;
+      std::ifstream in(fileName, std::ios::binary);
+      if (!in.is_open()) {
+         LOG(INFO) << TAG << "No checkpoint file " << fileName << " to restore from.";
+         return students;
+      }
+      std::string magic(Magic.length(), '\0');
+      in.read(&magic[0], magic.length());
+      const bool hasSources = (magic == Magic);
+      if (!in || (!hasSources && magic != MagicV1)) {
+         LOG(WARNING) << TAG << "File " << fileName << " is not a checkpoint file, ignoring it.";
+         return students;
+      }
+      while (in) {
+         char type = 0;
+         uint8_t lengthBytes[4];
+         in.get(type);
+         in.read(reinterpret_cast<char*>(lengthBytes), sizeof(lengthBytes));
+         if (!in) {
+            break;
+         }
+         uint32_t length = lengthBytes[0] | (lengthBytes[1] << 8) | (lengthBytes[2] << 16) | (uint32_t(lengthBytes[3]) << 24);
+         std::vector<uint8_t> payload(length);
+         in.read(reinterpret_cast<char*>(payload.data()), length);
+         if (!in) {
+            LOG(WARNING) << TAG << "Truncated record at the end of the checkpoint file, ignored.";
+            break;
+         }
+         if (type == HeldRecord) {
+            if (!hasSources) {
+               // Old format: keep the records in the current format, with an unknown source.
+               payload.insert(payload.begin(), static_cast<uint8_t>(StudentSource::Unknown));
+            }
+            try {
+               if (payload.empty()) {
+                  throw std::invalid_argument("empty record");
+               }
+               StudentDataItem student = nlohmann::json::from_cbor(payload.begin() + 1, payload.end()).get<StudentDataItem>();
+               written[student.getKey()] = std::move(payload);
+            } catch (const std::exception & e) {
+               LOG(WARNING) << TAG << "Invalid student record in the checkpoint file: " << e.what();
+            }
+         } else if (type == ReleasedRecord) {
+            written.erase(StudentKey(std::string(payload.begin(), payload.end())));
+         }
+         recordsInFile++;
+      }
+      for (const auto & entry : written) {
+         const std::vector<uint8_t> & payload = entry.second;
+         StudentSource source = static_cast<StudentSource>(payload[0]);
+         if (source != StudentSource::Network && source != StudentSource::File) {
+            source = StudentSource::Unknown;
+         }
+         students.emplace_back(std::make_unique<StudentDataItem>(nlohmann::json::from_cbor(payload.begin() + 1, payload.end()).get<StudentDataItem>()), source);
+      }
+      LOG(INFO) << TAG << "Restored " << students.size() << " students from the checkpoint.";
+      return students;
+   }
+   
+   /** Starts the background thread writing the checkpoints. The file is first
+    compacted to contain only the students restored from it. */
+   void StudentCheckpointer::start() {
+      if (running) {
+         return;
+      }
+      compact();
+      running = true;
+      writerThread = std::thread(&StudentCheckpointer::run, this);
+   }
+   
+   /** Stops the background thread, writing the changes still pending. */
+   void StudentCheckpointer::stop() {
+      {
+         std::lock_guard<std::mutex> guard(pendingGuard);
+         if (!running) {
+            return;
+         }
+         running = false;
+      }
+      wakeUp.notify_one();
+      if (writerThread.joinable()) {
+         writerThread.join();
+      }
+      writePending();
+      file.close();
+   }
+   
+   /**
+    Records that the handler now holds the student. Called while the handler holds its lock,
+    so this only copies the student to the pending changes.
+    @param student The student held by the handler.
+    @param source Where the held student came from.
+    */
+   void StudentCheckpointer::studentHeld(const StudentDataItem & student, StudentSource source) {
+      std::lock_guard<std::mutex> guard(pendingGuard);
+      pending.push_back(Change{HeldRecord, student.getKey(), source, std::make_unique<StudentDataItem>(student)});
+   }
+   
+   /**
+    Records that the handler no longer holds the student (it was merged and passed on).
+    @param key The key of the released student.
+    */
+   void StudentCheckpointer::studentReleased(const StudentKey & key) {
+      std::lock_guard<std::mutex> guard(pendingGuard);
+      pending.push_back(Change{ReleasedRecord, key, StudentSource::Unknown, nullptr});
+   }
+   
+   /** The writer thread, writing the pending changes periodically until stopped. */
+   void StudentCheckpointer::run() {
+      std::unique_lock<std::mutex> lock(pendingGuard);
+      while (running) {
+         wakeUp.wait_for(lock, interval, [this] { return !running; });
+         lock.unlock();
+         writePending();
+         lock.lock();
+      }
+   }
+   
+   /** Takes the pending changes and appends them to the file. Compacts the file
+    if it has grown much larger than the state it describes. */
+   void StudentCheckpointer::writePending() {
+      std::vector<Change> changes;
+      {
+         std::lock_guard<std::mutex> guard(pendingGuard);
+         changes.swap(pending);
+      }
+      if (changes.empty() || !file.is_open()) {
+         return;
+      }
+      for (const Change & change : changes) {
+         if (change.type == HeldRecord) {
+            std::vector<uint8_t> payload(1, static_cast<uint8_t>(change.source));
+            nlohmann::json::to_cbor(nlohmann::json(*change.student), payload);
+            appendRecord(file, HeldRecord, payload.data(), static_cast<uint32_t>(payload.size()));
+            written[change.key] = std::move(payload);
+         } else {
+            std::string id = change.key.toString();
+            appendRecord(file, ReleasedRecord, reinterpret_cast<const uint8_t*>(id.data()), static_cast<uint32_t>(id.length()));
+            written.erase(change.key);
+         }
+         recordsInFile++;
+      }
+      file.flush();
+      if (recordsInFile > 1024 && recordsInFile > 4 * written.size()) {
+         compact();
+      }
+   }
+   
+   void StudentCheckpointer::appendRecord(std::ofstream & out, char type, const uint8_t * data, uint32_t length) {
+      const char header[5] = {type, char(length & 0xff), char((length >> 8) & 0xff), char((length >> 16) & 0xff), char((length >> 24) & 0xff)};
+      out.write(header, sizeof(header));
+      out.write(reinterpret_cast<const char*>(data), length);
+   }
+   
+   /** Rewrites the file to contain only the students currently held. The new file is
+    written next to the old one and then renamed over it, so a valid checkpoint exists at all times. */
+   void StudentCheckpointer::compact() {
+      if (file.is_open()) {
+         file.close();
+      }
+      const std::string tempName = fileName + ".tmp";
+      std::ofstream out(tempName, std::ios::binary | std::ios::trunc);
+      if (!out.is_open()) {
+         LOG(WARNING) << TAG << "Could not open " << tempName << " for writing the checkpoint.";
+         return;
+      }
+      out.write(Magic.data(), Magic.length());
+      for (const auto & entry : written) {
+         appendRecord(out, HeldRecord, entry.second.data(), static_cast<uint32_t>(entry.second.size()));
+      }
+      out.close();
+      if (std::rename(tempName.c_str(), fileName.c_str()) != 0) {
+         LOG(WARNING) << TAG << "Could not replace the checkpoint file " << fileName;
+      }
+      recordsInFile = written.size();
+      file.open(fileName, std::ios::binary | std::ios::app);
+      LOG(INFO) << TAG << "Checkpoint compacted, holding " << written.size() << " students.";
+   }
+   
+   
+} //namespace
@@ -0,0 +1,426 @@
+//
+//  StudentColumnFile.cpp
+//  PipesAndFiltersFramework
+//
+//  Created by Antti Juustila on 19.10.2026.
+//  Copyright (c) 2026 Antti Juustila. All rights reserved.
+//
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <g3log/g3log.hpp>
+
+#include <StudentNodeElements/StudentColumnFile.h>
+#include <StudentNodeElements/StudentDataItem.h>
+
+
+namespace OHARStudent {
+   
+   const std::string StudentColumnFile::Magic{"SNECOLS1"};
+   
+   namespace {
+      /** Writes a value in the host byte order. */
+      template <typename T>
+      void writeValue(std::ostream & out, T value) {
+         out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+      }
+      
+      /** Pads the file with zeros to the next 8 byte boundary. */
+      void align(std::ostream & out) {
+         static const char zeros[8] = {0};
+         std::streamoff position = out.tellp();
+         if (position % 8 != 0) {
+            out.write(zeros, 8 - position % 8);
+         }
+      }
+      
+      /** Reads a value in the host byte order from a possibly unaligned location. */
+      template <typename T>
+      T readValue(const char * from) {
+         T value;
+         std::memcpy(&value, from, sizeof(T));
+         return value;
+      }
+   }
+   
+   
+   const std::string StudentColumnWriter::TAG{"SColumnWriter "};
+   
+   /** Creates the writer and opens the spool files of the columns.
+    @param fileName The report file to write. */
+   StudentColumnWriter::StudentColumnWriter(const std::string & fileName)
+   : fileName(fileName), rowCount(0), spooling(false), closed(false)
+   {
+      spooling = ids.offsets.open(fileName + ".id-offsets.tmp")
+         && ids.characters.open(fileName + ".id.tmp")
+         && studyPrograms.offsets.open(fileName + ".program-offsets.tmp")
+         && studyPrograms.characters.open(fileName + ".program.tmp")
+         && examPoints.open(fileName + ".exam.tmp")
+         && exercisePoints.open(fileName + ".exercises.tmp")
+         && courseProjectPoints.open(fileName + ".project.tmp")
+         && grades.open(fileName + ".grade.tmp");
+      if (spooling) {
+         const uint64_t first = 0;
+         ids.offsets.append(&first, sizeof(first));
+         studyPrograms.offsets.append(&first, sizeof(first));
+      } else {
+         LOG(WARNING) << TAG << "Could not open the column spool files for " << fileName << ", the report is not written.";
+         removeSpools();
+      }
+   }
+   
+   /** Writes the file, if not closed already. */
+   StudentColumnWriter::~StudentColumnWriter() {
+      close();
+   }
+   
+   /** Opens the spool file, replacing an old one.
+    @param name The file name.
+    @returns True if the file was opened. */
+   bool StudentColumnWriter::Spool::open(const std::string & name) {
+      fileName = name;
+      file.open(name, std::ios::binary | std::ios::trunc);
+      return file.is_open();
+   }
+   
+   void StudentColumnWriter::Spool::append(const void * data, std::size_t length) {
+      file.write(static_cast<const char*>(data), length);
+      bytes += length;
+   }
+   
+   void StudentColumnWriter::StringColumn::append(const std::string & value) {
+      characters.append(value.data(), value.length());
+      offsets.append(&characters.bytes, sizeof(characters.bytes));
+   }
+   
+   /** Adds a student to the columns.
+    @param student The student to add. */
+   void StudentColumnWriter::write(const StudentDataItem & student) {
+      std::lock_guard<std::mutex> guard(columnGuard);
+      if (closed) {
+         LOG(WARNING) << TAG << "File " << fileName << " already written, student " << student.getId() << " not added.";
+         return;
+      }
+      if (!spooling) {
+         return;
+      }
+      auto appendNumber = [] (Spool & spool, int32_t value) {
+         spool.append(&value, sizeof(value));
+      };
+      ids.append(student.getId());
+      studyPrograms.append(student.getStudyProgram());
+      appendNumber(examPoints, student.getExamPoints());
+      appendNumber(exercisePoints, student.getExercisePointsTotal());
+      appendNumber(courseProjectPoints, student.getCourseProjectPoints());
+      appendNumber(grades, student.getGrade());
+      rowCount++;
+   }
+   
+   /** Copies a spool file to the end of the report file. Call with columnGuard locked.
+    @param out The report file.
+    @param spool The spool, closed when copied.
+    @returns True if the whole spool was copied. */
+   bool StudentColumnWriter::copySpool(std::ofstream & out, Spool & spool) {
+      spool.file.close();
+      if (!spool.file) {
+         return false;
+      }
+      std::ifstream in(spool.fileName, std::ios::binary);
+      std::vector<char> buffer(1 << 20);
+      uint64_t copied = 0;
+      while (in && out) {
+         in.read(buffer.data(), buffer.size());
+         out.write(buffer.data(), in.gcount());
+         copied += static_cast<uint64_t>(in.gcount());
+      }
+      return static_cast<bool>(out) && copied == spool.bytes;
+   }
+   
+   /** Removes the spool files. */
+   void StudentColumnWriter::removeSpools() {
+      for (Spool * spool : {&ids.offsets, &ids.characters, &studyPrograms.offsets, &studyPrograms.characters,
+                            &examPoints, &exercisePoints, &courseProjectPoints, &grades}) {
+         if (spool->file.is_open()) {
+            spool->file.close();
+         }
+         if (!spool->fileName.empty()) {
+            std::remove(spool->fileName.c_str());
+         }
+      }
+   }
+   
+   /** Writes the columns into the file. Students cannot be added after this.
+    @returns True if the file was written. */
+   bool StudentColumnWriter::close() {
+      std::lock_guard<std::mutex> guard(columnGuard);
+      if (closed) {
+         return true;
+      }
+      closed = true;
+      if (!spooling) {
+         return false;
+      }
+      std::string tempName = fileName + ".tmp";
+      std::ofstream out(tempName, std::ios::binary | std::ios::trunc);
+      if (!out.is_open()) {
+         LOG(WARNING) << TAG << "Could not open " << tempName << " for writing.";
+         removeSpools();
+         return false;
+      }
+      struct Entry {
+         uint32_t column;
+         uint32_t type;
+         uint64_t offset;
+         uint64_t length;
+      };
+      std::vector<Entry> index;
+      bool copied = true;
+      auto writeStrings = [&] (uint32_t column, StringColumn & strings) {
+         align(out);
+         uint64_t begin = static_cast<uint64_t>(out.tellp());
+         copied = copied && copySpool(out, strings.offsets) && copySpool(out, strings.characters);
+         index.push_back({column, StudentColumnFile::StringColumn, begin, static_cast<uint64_t>(out.tellp()) - begin});
+      };
+      auto writeNumbers = [&] (uint32_t column, Spool & numbers) {
+         align(out);
+         uint64_t begin = static_cast<uint64_t>(out.tellp());
+         copied = copied && copySpool(out, numbers);
+         index.push_back({column, StudentColumnFile::Int32Column, begin, numbers.bytes});
+      };
+      out.write(StudentColumnFile::Magic.data(), StudentColumnFile::Magic.length());
+      writeStrings(StudentColumnFile::Id, ids);
+      writeStrings(StudentColumnFile::StudyProgram, studyPrograms);
+      writeNumbers(StudentColumnFile::ExamPoints, examPoints);
+      writeNumbers(StudentColumnFile::ExercisePoints, exercisePoints);
+      writeNumbers(StudentColumnFile::CourseProjectPoints, courseProjectPoints);
+      writeNumbers(StudentColumnFile::Grade, grades);
+      removeSpools();
+      if (!copied) {
+         LOG(WARNING) << TAG << "Could not copy the column spool files into " << tempName;
+         out.close();
+         std::remove(tempName.c_str());
+         return false;
+      }
+      align(out);
+      uint64_t footer = static_cast<uint64_t>(out.tellp());
+      writeValue<uint32_t>(out, StudentColumnFile::ByteOrderMark);
+      writeValue<uint32_t>(out, static_cast<uint32_t>(index.size()));
+      writeValue<uint64_t>(out, rowCount);
+      for (const Entry & entry : index) {
+         writeValue(out, entry.column);
+         writeValue(out, entry.type);
+         writeValue(out, entry.offset);
+         writeValue(out, entry.length);
+      }
+      writeValue(out, footer);
+      out.write(StudentColumnFile::Magic.data(), StudentColumnFile::Magic.length());
+      out.close();
+      if (!out) {
+         LOG(WARNING) << TAG << "Could not write " << tempName;
+         std::remove(tempName.c_str());
+         return false;
+      }
+      if (std::rename(tempName.c_str(), fileName.c_str()) != 0) {
+         LOG(WARNING) << TAG << "Could not replace the report file " << fileName;
+         return false;
+      }
+      LOG(INFO) << TAG << "Wrote " << rowCount << " students to " << fileName;
+      return true;
+   }
+   
+   
+   const std::string StudentColumnReader::TAG{"SColumnReader "};
+   
+   StudentColumnReader::StudentColumnReader()
+   : mapping(nullptr), mappingSize(0), rowCount(0)
+   {
+   }
+   
+   StudentColumnReader::~StudentColumnReader() {
+      close();
+   }
+   
+   /**
+    Opens a report file by memory mapping it, and reads the footer index.
+    @param fileName The report file written by StudentColumnWriter.
+    @returns True if the file was opened, false if it could not be mapped or is not a valid report file.
+    */
+   bool StudentColumnReader::open(const std::string & fileName) {
+      close();
+      int fd = ::open(fileName.c_str(), O_RDONLY);
+      if (fd < 0) {
+         LOG(WARNING) << TAG << "Could not open " << fileName;
+         return false;
+      }
+      struct stat info;
+      if (fstat(fd, &info) == 0 && info.st_size > 0) {
+         void * address = mmap(nullptr, static_cast<std::size_t>(info.st_size), PROT_READ, MAP_SHARED, fd, 0);
+         if (address != MAP_FAILED) {
+            mapping = static_cast<const char*>(address);
+            mappingSize = static_cast<std::size_t>(info.st_size);
+         }
+      }
+      ::close(fd);
+      if (!mapping) {
+         LOG(WARNING) << TAG << "Could not map " << fileName;
+         return false;
+      }
+      if (!readIndex(fileName)) {
+         close();
+         return false;
+      }
+      return true;
+   }
+   
+   /** Validates the file and locates the column blocks using the footer index. */
+   bool StudentColumnReader::readIndex(const std::string & fileName) {
+      const std::string & magic = StudentColumnFile::Magic;
+      const std::size_t headerSize = 16;
+      const std::size_t entrySize = 24;
+      const std::size_t trailerSize = sizeof(uint64_t) + magic.length();
+      if (mappingSize < magic.length() + headerSize + trailerSize
+          || std::memcmp(mapping, magic.data(), magic.length()) != 0
+          || std::memcmp(mapping + mappingSize - magic.length(), magic.data(), magic.length()) != 0) {
+         LOG(WARNING) << TAG << fileName << " is not a columnar report file.";
+         return false;
+      }
+      uint64_t footer = readValue<uint64_t>(mapping + mappingSize - trailerSize);
+      if (footer < magic.length() || footer > mappingSize - trailerSize - headerSize) {
+         LOG(WARNING) << TAG << "Invalid footer offset in " << fileName;
+         return false;
+      }
+      const char * index = mapping + footer;
+      if (readValue<uint32_t>(index) != StudentColumnFile::ByteOrderMark) {
+         LOG(WARNING) << TAG << fileName << " was written on a host with another byte order.";
+         return false;
+      }
+      uint32_t columns = readValue<uint32_t>(index + 4);
+      uint64_t rows = readValue<uint64_t>(index + 8);
+      if (columns > (mappingSize - trailerSize - footer - headerSize) / entrySize) {
+         LOG(WARNING) << TAG << "Invalid footer index in " << fileName;
+         return false;
+      }
+      for (uint32_t count = 0; count < columns; count++) {
+         const char * entry = index + headerSize + count * entrySize;
+         uint32_t column = readValue<uint32_t>(entry);
+         uint32_t type = readValue<uint32_t>(entry + 4);
+         uint64_t offset = readValue<uint64_t>(entry + 8);
+         uint64_t length = readValue<uint64_t>(entry + 16);
+         if (offset > footer || length > footer - offset) {
+            LOG(WARNING) << TAG << "Column " << column << " is outside the file " << fileName;
+            return false;
+         }
+         if (column >= StudentColumnFile::ColumnCount) {
+            continue; // Written by a newer version, not known here.
+         }
+         bool valid = false;
+         if (type == StudentColumnFile::Int32Column) {
+            valid = length == rows * sizeof(int32_t);
+         } else if (type == StudentColumnFile::StringColumn) {
+            valid = rows < length / sizeof(uint64_t)
+               && readValue<uint64_t>(mapping + offset + rows * sizeof(uint64_t)) <= length - (rows + 1) * sizeof(uint64_t);
+         }
+         if (!valid) {
+            LOG(WARNING) << TAG << "Invalid column " << column << " in " << fileName;
+            return false;
+         }
+         blocks[column].type = type;
+         blocks[column].begin = mapping + offset;
+         blocks[column].length = length;
+      }
+      rowCount = static_cast<std::size_t>(rows);
+      return true;
+   }
+   
+   /** Unmaps the file. */
+   void StudentColumnReader::close() {
+      if (mapping) {
+         munmap(const_cast<char*>(mapping), mappingSize);
+      }
+      mapping = nullptr;
+      mappingSize = 0;
+      rowCount = 0;
+      for (Block & block : blocks) {
+         block = Block();
+      }
+   }
+   
+   /** @returns The number of students in the file. */
+   std::size_t StudentColumnReader::getRowCount() const {
+      return rowCount;
+   }
+   
+   /**
+    Gets a value of a string column.
+    @param column The column, Id or StudyProgram.
+    @param row The row, less than getRowCount().
+    @returns The value, pointing into the mapped file. Empty if the column is not in the file
+    or the row is out of range.
+    */
+   std::string_view StudentColumnReader::getString(StudentColumnFile::Column column, std::size_t row) const {
+      if (column >= StudentColumnFile::ColumnCount || row >= rowCount) {
+         return std::string_view();
+      }
+      const Block & block = blocks[column];
+      if (block.type != StudentColumnFile::StringColumn) {
+         return std::string_view();
+      }
+      const char * characters = block.begin + (rowCount + 1) * sizeof(uint64_t);
+      const uint64_t charactersLength = block.length - (rowCount + 1) * sizeof(uint64_t);
+      uint64_t begin = readValue<uint64_t>(block.begin + row * sizeof(uint64_t));
+      uint64_t end = readValue<uint64_t>(block.begin + (row + 1) * sizeof(uint64_t));
+      if (begin > end || end > charactersLength) {
+         return std::string_view();
+      }
+      return std::string_view(characters + begin, end - begin);
+   }
+   
+   /**
+    Gets the values of a number column.
+    @param column The column, ExamPoints, ExercisePoints, CourseProjectPoints or Grade.
+    @returns Pointer to getRowCount() values in the mapped file, null if the column is not in the file.
+    */
+   const int32_t * StudentColumnReader::getNumbers(StudentColumnFile::Column column) const {
+      if (column >= StudentColumnFile::ColumnCount || blocks[column].type != StudentColumnFile::Int32Column) {
+         return nullptr;
+      }
+      return reinterpret_cast<const int32_t*>(blocks[column].begin);
+   }
+   
+   /**
+    Creates a student object from one row. The exercise points of the student are the total
+    points, since only the total is in the report.
+    @param row The row, less than getRowCount().
+    @returns The student, null if the row is out of range.
+    */
+   std::unique_ptr<StudentDataItem> StudentColumnReader::getStudent(std::size_t row) const {
+      if (row >= rowCount) {
+         return nullptr;
+      }
+      std::unique_ptr<StudentDataItem> student = std::make_unique<StudentDataItem>();
+      student->setId(std::string(getString(StudentColumnFile::Id, row)));
+      student->setStudyProgram(std::string(getString(StudentColumnFile::StudyProgram, row)));
+      if (const int32_t * values = getNumbers(StudentColumnFile::ExamPoints)) {
+         student->setExamPoints(values[row]);
+      }
+      if (const int32_t * values = getNumbers(StudentColumnFile::ExercisePoints)) {
+         student->addToExercisePoints(values[row]);
+      }
+      if (const int32_t * values = getNumbers(StudentColumnFile::CourseProjectPoints)) {
+         student->setCourseProjectPoints(values[row]);
+      }
+      if (const int32_t * values = getNumbers(StudentColumnFile::Grade)) {
+         student->setGrade(values[row]);
+      }
+      return student;
+   }
+   
+   
+} //namespace
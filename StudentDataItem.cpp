@@ -6,31 +6,102 @@
 //  Copyright (c) 2014 Antti Juustila. All rights reserved.
 //
 
+#include <algorithm>
+#include <thread>
 #include <vector>
 #include <boost/algorithm/string.hpp>
 
 #include <g3log/g3log.hpp>
 
 #include <StudentNodeElements/StudentDataItem.h>
+#include <StudentNodeElements/StudentRecordFormatter.h>
 #include <StudentNodeElements/GradeCalculator.h>
 
 namespace OHARStudent {
    
-   GradeCalculator * StudentDataItem::calculator = 0;
+   std::shared_ptr<const GradingPolicy> StudentDataItem::gradingPolicy;
+   std::mutex StudentDataItem::policyGuard;
+   std::atomic<uint64_t> StudentDataItem::policyGeneration{0};
+   std::atomic<uint32_t> StudentDataItem::lastPolicyVersion{0};
    const std::string StudentDataItem::TAG{"SDataItem "};
    
+   namespace {
+      /**
+       A thread's copy of the grading policy, and the policy generation it was copied at.
+       The copies are registered, so that publishing a new policy can drop the superseded
+       copies of the threads not grading at the moment, instead of them keeping the old
+       calculator alive until they grade again.
+       */
+      struct PolicyCopy {
+         PolicyCopy();
+         ~PolicyCopy();
+         uint64_t generation = UINT64_MAX;
+         std::shared_ptr<const GradingPolicy> policy;
+         /** The number of GradingPolicyRefs in use in the owning thread. Written only by the owner. */
+         std::atomic<unsigned> users{0};
+      };
+      std::mutex copiesGuard;
+      std::vector<PolicyCopy *> policyCopies;
+      thread_local PolicyCopy threadPolicy;
+      
+      PolicyCopy::PolicyCopy() {
+         std::lock_guard<std::mutex> guard(copiesGuard);
+         policyCopies.push_back(this);
+      }
+      
+      PolicyCopy::~PolicyCopy() {
+         std::lock_guard<std::mutex> guard(copiesGuard);
+         policyCopies.erase(std::find(policyCopies.begin(), policyCopies.end(), this));
+      }
+      
+      /**
+       Takes the policy from the copies of the threads not using theirs; call after changing the
+       policy generation. A thread using its copy drops it itself when done (see GradingPolicyRef).
+       @param dropped Gets the taken policies, to be released after the locks have been released.
+       */
+      void dropUnusedCopies(std::vector<std::shared_ptr<const GradingPolicy>> & dropped) {
+         std::lock_guard<std::mutex> guard(copiesGuard);
+         for (PolicyCopy * copy : policyCopies) {
+            // The generation was changed before this, so a thread starting to use its copy now will copy the policy again.
+            if (copy->users.load() == 0 && copy->policy) {
+               dropped.push_back(std::move(copy->policy));
+            }
+         }
+      }
+   }
+   
+   GradingPolicyRef::~GradingPolicyRef() {
+      StudentDataItem::releaseGradingPolicy();
+   }
+   
    StudentDataItem::StudentDataItem()
-   : examPoints(-1), courseProjectPoints(-1),
-   grade(-1)
+   : rawFormat(RawFormat::None), examPoints(-1), exercisePointsTotal(0), courseProjectPoints(-1),
+   grade(-1), gradePolicyVersion(0)
    {
    }
    
    StudentDataItem::StudentDataItem(const StudentDataItem & another)
-   : OHARBase::DataItem(another), name(another.name), department(another.department),
-   examPoints(another.examPoints), exercisePoints(another.exercisePoints),
-   courseProjectPoints(another.courseProjectPoints), grade(another.grade)
+   : OHARBase::DataItem(another), rawFormat(RawFormat::None)
    {
-      
+      // Another thread may be decoding the other student; keep it from doing so while copying.
+      const RawFormat format = another.claimRaw();
+      rawRecord = another.rawRecord;
+      columnOffsets = another.columnOffsets;
+      rawContentType = another.rawContentType;
+      sourceJson = another.sourceJson;
+      key = another.key;
+      name = another.name;
+      department = another.department;
+      examPoints = another.examPoints;
+      exercisePoints = another.exercisePoints;
+      exercisePointsTotal = another.exercisePointsTotal;
+      courseProjectPoints = another.courseProjectPoints;
+      grade = another.grade;
+      gradePolicyVersion = another.gradePolicyVersion;
+      rawFormat.store(format, std::memory_order_relaxed);
+      if (format != RawFormat::None) {
+         another.rawFormat.store(format, std::memory_order_release);
+      }
    }
    
    std::unique_ptr<OHARBase::DataItem> StudentDataItem::clone() const {
@@ -40,119 +111,435 @@ namespace OHARStudent {
    StudentDataItem::~StudentDataItem() {
    }
    
+   /**
+    Sets the id of the student and updates the compact key used in comparing students.
+    All changes to the id go through this method, so the key always matches the id:
+    DataItem::setId is not virtual, and calling it through a DataItem reference would
+    leave the key of the old id.
+    @param theId The student id.
+    */
+   void StudentDataItem::setId(const std::string & theId) {
+      OHARBase::DataItem::setId(theId);
+      key = StudentKey(theId);
+      sourceJson.reset();
+   }
+   
+   /** @returns The compact key of the student, for fast lookups and comparisons. */
+   const StudentKey & StudentDataItem::getKey() const {
+      return key;
+   }
+   
    const std::string & StudentDataItem::getName() const {
+      ensureDecoded();
       return name;
    }
    
    const std::string & StudentDataItem::getStudyProgram() const {
+      ensureDecoded();
       return department;
    }
    
    int StudentDataItem::getExamPoints() const {
+      ensureDecoded();
       return examPoints;
    }
    
    int StudentDataItem::getExercisePointsTotal() const {
-      return std::accumulate(exercisePoints.begin(), exercisePoints.end(), 0);
+      ensureDecoded();
+      return exercisePointsTotal;
    }
    
    const std::vector<int> & StudentDataItem::getExercisePoints() const {
+      ensureDecoded();
       return exercisePoints;
    }
    
    int StudentDataItem::getCourseProjectPoints() const {
+      ensureDecoded();
       return courseProjectPoints;
    }
    
-   void StudentDataItem::setGradeCalculator(GradeCalculator * calc) {
-      delete calculator;
-      calculator = 0;
-      calculator = calc;
+   /**
+    Publishes a new grade calculator for grading all students, replacing the previous one.
+    Students being graded by the previous calculator at the same time finish with it; it is
+    deleted when no longer used.
+    @param calc The calculator, owned by the student class from now on. Null to stop grading.
+    @returns The version number of the new grading policy.
+    */
+   uint32_t StudentDataItem::setGradeCalculator(GradeCalculator * calc) {
+      return setGradeCalculator(std::shared_ptr<GradeCalculator>(calc));
+   }
+   
+   /**
+    Publishes a new grade calculator for grading all students, see setGradeCalculator above.
+    @param calc The calculator, null to stop grading.
+    @returns The version number of the new grading policy.
+    */
+   uint32_t StudentDataItem::setGradeCalculator(std::shared_ptr<GradeCalculator> calc) {
+      const std::string name = calc ? calc->getName() : std::string("none");
+      std::vector<std::shared_ptr<const GradingPolicy>> previous;
+      uint32_t version = 0;
+      {
+         std::lock_guard<std::mutex> guard(policyGuard);
+         version = ++lastPolicyVersion;
+         previous.push_back(std::move(gradingPolicy));
+         if (calc) {
+            gradingPolicy = std::make_shared<const GradingPolicy>(GradingPolicy{std::move(calc), name, version});
+         }
+         policyGeneration.fetch_add(1);
+         dropUnusedCopies(previous);
+      }
+      // The version is recorded in the graded students; the log maps it back to the grader.
+      LOG(INFO) << TAG << "Published grading policy version " << version << ": " << name;
+      return version;
+   }
+   
+   /**
+    Removes the grade calculator, if it is still the one published with the given version.
+    A calculator published later by someone else is not removed.
+    @param version The version returned when the calculator was published.
+    @returns True if the calculator was removed.
+    */
+   bool StudentDataItem::removeGradeCalculator(uint32_t version) {
+      std::shared_ptr<const GradingPolicy> removed;
+      std::vector<std::shared_ptr<const GradingPolicy>> dropped;
+      {
+         std::lock_guard<std::mutex> guard(policyGuard);
+         if (!gradingPolicy || gradingPolicy->version != version) {
+            return false;
+         }
+         removed = std::move(gradingPolicy);
+         policyGeneration.fetch_add(1);
+         dropUnusedCopies(dropped);
+      }
+      LOG(INFO) << TAG << "Removed grading policy version " << version << ": " << removed->name;
+      return true;
+   }
+   
+   /**
+    Gets the grading policy currently used. Each thread keeps a copy of the policy, and only
+    copies it again (under policyGuard) after a new policy has been published, so getting the
+    policy takes no lock and does not touch the reference count shared by the threads while
+    the policy does not change. A replaced calculator is deleted when no thread uses it any more:
+    the copies of the threads not grading are dropped when a new policy is published, and a
+    thread grading meanwhile drops its copy when it releases the returned reference.
+    @returns The grading policy currently used, empty if there is none. The policy stays valid
+    as long as the returned reference exists, even if a new one is published. */
+   GradingPolicyRef StudentDataItem::getGradingPolicy() {
+      PolicyCopy & copy = threadPolicy;
+      // Marked used before checking the generation: a publisher changes the generation before
+      // dropping the unused copies, so either this thread sees the new generation, or the
+      // publisher sees the copy used and leaves it alone.
+      copy.users.store(copy.users.load(std::memory_order_relaxed) + 1);
+      if (copy.generation != policyGeneration.load()) {
+         std::lock_guard<std::mutex> guard(policyGuard);
+         copy.policy = gradingPolicy;
+         copy.generation = policyGeneration.load(std::memory_order_relaxed);
+      }
+      return GradingPolicyRef(copy.policy.get());
+   }
+   
+   /** Releases a reference got from getGradingPolicy; drops the thread's copy of the policy if it has been superseded. */
+   void StudentDataItem::releaseGradingPolicy() {
+      PolicyCopy & copy = threadPolicy;
+      const unsigned users = copy.users.load(std::memory_order_relaxed) - 1;
+      std::shared_ptr<const GradingPolicy> superseded;
+      if (users == 0 && copy.generation != policyGeneration.load()) {
+         // Publishers leave the copy alone while it is used, so it can be dropped without a lock.
+         superseded = std::move(copy.policy);
+      }
+      copy.users.store(users, std::memory_order_release);
    }
    
    int StudentDataItem::getGrade() const {
+      ensureDecoded();
       return grade;
    }
    
+   /** @returns The version of the grading policy which gave the grade, zero if not known. */
+   uint32_t StudentDataItem::getGradePolicyVersion() const {
+      ensureDecoded();
+      return gradePolicyVersion;
+   }
+   
    void StudentDataItem::setName(const std::string & theName) {
+      modified();
       name = theName;
    }
    
    void StudentDataItem::setStudyProgram(const std::string & theDept) {
+      modified();
       department = theDept;
    }
    
    void StudentDataItem::setExamPoints(int pts) {
+      modified();
       examPoints = pts;
    }
    
    void StudentDataItem::addToExercisePoints(int pts) {
+      modified();
       exercisePoints.push_back(pts);
+      exercisePointsTotal += pts;
    }
    
    void StudentDataItem::setExercisePoints(const std::vector<int> & newPoints) {
+      modified();
       exercisePoints = newPoints;
+      exercisePointsTotal = std::accumulate(exercisePoints.begin(), exercisePoints.end(), 0);
    }
    
    void StudentDataItem::setCourseProjectPoints(int pts) {
+      modified();
       courseProjectPoints = pts;
    }
    
    void StudentDataItem::setGrade(int g) {
+      modified();
       grade = g;
    }
    
+   /**
+    Sets the version of the grading policy which gave the grade; use only for externalizing, like setGrade.
+    @param version The policy version.
+    */
+   void StudentDataItem::setGradePolicyVersion(uint32_t version) {
+      modified();
+      gradePolicyVersion = version;
+   }
+   
+   /** Calculates the grade with the grading policy currently published. */
    void StudentDataItem::calculateGrade() {
-      if (calculator) {
-         grade = calculator->calculate(*this);
-         LOG(INFO) << TAG << "Calculated grade for the student: " << grade;
+      GradingPolicyRef policy = getGradingPolicy();
+      if (policy) {
+         calculateGrade(*policy);
       } else {
          LOG(WARNING) << TAG << "No calculator provided for grading!!";
       }
    }
    
+   /**
+    Calculates the grade with the given grading policy, and records the version of the policy.
+    @param policy The policy, e.g. a snapshot from getGradingPolicy held by the caller.
+    */
+   void StudentDataItem::calculateGrade(const GradingPolicy & policy) {
+      modified();
+      grade = policy.calculator->calculate(*this);
+      gradePolicyVersion = policy.version;
+      LOG(INFO) << TAG << "Calculated grade for the student: " << grade;
+   }
+   
    /**
     Parse the student data from a tsv record. Depending on the content type, the number of
     values and the meaning of the tab separated values differ.
     @param fromString The tsv separated student record.
     @param contentType The type of student data to read (basic info, exam points, etc.).
     @return Returns true if succeeded in parsing the data, false otherwise.
+    Throws std::invalid_argument if a points value is not a number.
     */
    bool StudentDataItem::parse(const std::string & fromString, const std::string & contentType) {
-      std::vector<std::string> strings;
-      boost::split(strings, fromString, boost::is_any_of("\t"));
-      LOG(INFO) << TAG << "Parsing student string; item count: " << strings.size();
+      if (!parseLazily(fromString, contentType)) {
+         return false;
+      }
+      rawFormat.store(RawFormat::None, std::memory_order_relaxed);
+      decodeFields(RawFormat::Tsv);
+      return true;
+   }
+   
+   /**
+    Parses the id of the student from a tsv record, and keeps the record for decoding the other
+    fields when they are first needed. The content type and the number of values are checked here;
+    if a points value is later found not to be a number, a warning is logged and the value is not set.
+    @param fromString The tsv separated student record.
+    @param contentType The type of student data to read (basic info, exam points, etc.).
+    @return Returns true if the record has the values required by the content type, false otherwise.
+    */
+   bool StudentDataItem::parseLazily(const std::string & fromString, const std::string & contentType) {
+      std::vector<uint32_t> columnStarts;
+      columnStarts.push_back(0);
+      for (std::size_t tab = fromString.find('\t'); tab != std::string::npos; tab = fromString.find('\t', tab + 1)) {
+         columnStarts.push_back(static_cast<uint32_t>(tab + 1));
+      }
+      return parseLazily(fromString, contentType, std::move(columnStarts));
+   }
+   
+   /**
+    Parses a tsv record whose columns have already been located (e.g. by DelimiterScanner),
+    so the record is not scanned again.
+    @param fromString The tsv separated student record.
+    @param contentType The type of student data to read (basic info, exam points, etc.).
+    @param columnStarts The offsets of the columns in the record, the first one being zero.
+    @return Returns true if succeeded in parsing the data, false otherwise.
+    Throws std::invalid_argument if a points value is not a number.
+    */
+   bool StudentDataItem::parse(const std::string & fromString, const std::string & contentType, std::vector<uint32_t> columnStarts) {
+      if (!parseLazily(fromString, contentType, std::move(columnStarts))) {
+         return false;
+      }
+      rawFormat.store(RawFormat::None, std::memory_order_relaxed);
+      decodeFields(RawFormat::Tsv);
+      return true;
+   }
+   
+   /**
+    Parses the id from a tsv record whose columns have already been located, see parseLazily.
+    @param fromString The tsv separated student record.
+    @param contentType The type of student data to read (basic info, exam points, etc.).
+    @param columnStarts The offsets of the columns in the record, the first one being zero.
+    @return Returns true if the record has the values required by the content type, false otherwise.
+    */
+   bool StudentDataItem::parseLazily(const std::string & fromString, const std::string & contentType, std::vector<uint32_t> columnStarts) {
+      std::size_t requiredColumns = 0;
       if (contentType == "summarydata") {
-         setId(strings.at(0));
-         setName(strings.at(1));
-         setStudyProgram(strings.at(2));
-         setExamPoints(std::stoi(strings.at(3)));
-         addToExercisePoints(std::stoi(strings.at(4)));
-         setCourseProjectPoints(std::stoi(strings.at(5)));
-         return true;
+         requiredColumns = 6;
       } else if (contentType == "studentdata") {
-         setId(strings.at(0));
-         setName(strings.at(1));
-         setStudyProgram(strings.at(2));
-         return true;
+         requiredColumns = 3;
       } else if (contentType == "exercisedata") {
-         setId(strings.at(0));
-         for (int count = 1; count < strings.size(); count++) {
-               exercisePoints.push_back(std::stoi(strings.at(count)));
-         }
-         return true;
-      } else if (contentType == "exerciseworkdata") {
-         setId(strings.at(0));
-         setCourseProjectPoints(std::stoi(strings.at(1)));
-         return true;
-      } else if (contentType == "examdata") {
-         setId(strings.at(0));
-         setExamPoints(std::stoi(strings.at(1)));
-         return true;
+         requiredColumns = 1;
+      } else if (contentType == "exerciseworkdata" || contentType == "examdata") {
+         requiredColumns = 2;
       } else {
          // UNKNOWN DATA TYPE
+         return false;
       }
-      return false;
+      ensureDecoded();
+      columnOffsets = std::move(columnStarts);
+      LOG(INFO) << TAG << "Parsing student string; item count: " << columnOffsets.size();
+      if (columnOffsets.size() < requiredColumns) {
+         LOG(WARNING) << TAG << "Too few values for " << contentType << ": " << columnOffsets.size();
+         return false;
+      }
+      rawRecord = std::make_shared<const std::string>(fromString);
+      rawContentType = contentType;
+      setId(column(0));
+      rawFormat.store(RawFormat::Tsv, std::memory_order_release);
+      return true;
+   }
+   
+   /**
+    Parses the id of the student from a JSON record, and keeps the record for decoding the other
+    fields when they are first needed. The record is also kept as the source JSON of the student,
+    until the student is modified.
+    @param json The student as JSON, in the format produced by to_json.
+    @return Returns true if the JSON is valid and has the student id, false otherwise.
+    */
+   bool StudentDataItem::parseJsonLazily(const std::string & json) {
+      ensureDecoded();
+      // Parse the whole JSON to validate it, but keep only the top level id in the result.
+      bool keepValue = false;
+      nlohmann::json idOnly = nlohmann::json::parse(json, [&keepValue] (int depth, nlohmann::json::parse_event_t event, nlohmann::json & parsed) {
+         if (depth == 0) {
+            return true;
+         }
+         if (depth == 1 && event == nlohmann::json::parse_event_t::key) {
+            keepValue = parsed == "id";
+         }
+         return keepValue;
+      }, false);
+      if (!idOnly.is_object() || idOnly.find("id") == idOnly.end() || !idOnly["id"].is_string()) {
+         return false;
+      }
+      setId(idOnly["id"].get<std::string>());
+      rawRecord = std::make_shared<const std::string>(json);
+      rawFormat.store(RawFormat::Json, std::memory_order_release);
+      sourceJson = rawRecord;
+      return true;
+   }
+   
+   /** Gets the JSON the student was parsed from with parseJsonLazily, if the student
+    has not been modified since.
+    @returns The original JSON, or null if not available. */
+   const std::string * StudentDataItem::getSourceJson() const {
+      return sourceJson.get();
+   }
+   
+   /** Decodes the lazily parsed fields, from a const getter. A record with an invalid
+    value is logged, and the fields decoded before the invalid value are kept. Only one
+    thread decodes; the others wait in claimRaw until the fields have been decoded. */
+   void StudentDataItem::decode() const {
+      const RawFormat format = claimRaw();
+      if (format == RawFormat::None) {
+         return;
+      }
+      try {
+         // The fields are logically part of the object's state already; only their decoding was postponed.
+         const_cast<StudentDataItem*>(this)->decodeFields(format);
+      } catch (const std::exception & e) {
+         LOG(WARNING) << TAG << "Invalid value in student " << id << ": " << e.what();
+      }
+      rawFormat.store(RawFormat::None, std::memory_order_release);
+   }
+   
+   /**
+    Takes exclusive access to the raw record, for decoding or copying it: the state is set to Busy.
+    If another thread has the access, waits until it is done.
+    @returns The format of the raw record, and the caller must then set the state; or None if the
+    student has been decoded, and the access was not taken.
+    */
+   StudentDataItem::RawFormat StudentDataItem::claimRaw() const {
+      RawFormat format = rawFormat.load(std::memory_order_acquire);
+      while (format != RawFormat::None) {
+         if (format == RawFormat::Busy) {
+            std::this_thread::yield();
+            format = rawFormat.load(std::memory_order_acquire);
+         } else if (rawFormat.compare_exchange_weak(format, RawFormat::Busy, std::memory_order_acquire)) {
+            return format;
+         }
+      }
+      return RawFormat::None;
+   }
+   
+   /** Decodes the fields from the raw record. Throws if a value is invalid.
+    @param format The format of the raw record. */
+   void StudentDataItem::decodeFields(RawFormat format) {
+      if (format == RawFormat::Json) {
+         StudentDataItem decoded = nlohmann::json::parse(*rawRecord).get<StudentDataItem>();
+         name = std::move(decoded.name);
+         department = std::move(decoded.department);
+         examPoints = decoded.examPoints;
+         exercisePoints = std::move(decoded.exercisePoints);
+         exercisePointsTotal = decoded.exercisePointsTotal;
+         courseProjectPoints = decoded.courseProjectPoints;
+         grade = decoded.grade;
+         gradePolicyVersion = decoded.gradePolicyVersion;
+      } else if (format == RawFormat::Tsv) {
+         if (rawContentType == "summarydata") {
+            name = column(1);
+            department = column(2);
+            examPoints = std::stoi(column(3));
+            exercisePoints.push_back(std::stoi(column(4)));
+            courseProjectPoints = std::stoi(column(5));
+         } else if (rawContentType == "studentdata") {
+            name = column(1);
+            department = column(2);
+         } else if (rawContentType == "exercisedata") {
+            for (std::size_t count = 1; count < columnOffsets.size(); count++) {
+               exercisePoints.push_back(std::stoi(column(count)));
+            }
+         } else if (rawContentType == "exerciseworkdata") {
+            courseProjectPoints = std::stoi(column(1));
+         } else if (rawContentType == "examdata") {
+            examPoints = std::stoi(column(1));
+         }
+      }
+      rawRecord.reset();
+      columnOffsets.clear();
+      exercisePointsTotal = std::accumulate(exercisePoints.begin(), exercisePoints.end(), 0);
+   }
+   
+   /** Called before the student is modified: decodes the fields and forgets the source JSON. */
+   void StudentDataItem::modified() {
+      ensureDecoded();
+      sourceJson.reset();
+   }
+   
+   /** Gets a value from the tsv raw record.
+    @param index The index of the column.
+    @returns The value. */
+   std::string StudentDataItem::column(std::size_t index) const {
+      std::size_t begin = columnOffsets.at(index);
+      std::size_t end = index + 1 < columnOffsets.size() ? columnOffsets[index + 1] - 1 : rawRecord->length();
+      return rawRecord->substr(begin, end - begin);
    }
    
 /**
@@ -165,7 +552,9 @@ namespace OHARStudent {
    bool StudentDataItem::addFrom(const OHARBase::DataItem & another) {
       const StudentDataItem * item = dynamic_cast<const StudentDataItem*>(&another);
       if (item) {
-         if (item->id == id) {
+         if (item->key == key) {
+            item->ensureDecoded();
+            modified();
             if (this->name.length() == 0) {
                this->name = item->name;
             }
@@ -177,12 +566,14 @@ namespace OHARStudent {
             }
             if (this->exercisePoints.empty()) {
                this->exercisePoints = item->exercisePoints;
+               this->exercisePointsTotal = item->exercisePointsTotal;
             }
             if (this->courseProjectPoints < 0) {
                this->courseProjectPoints = item->courseProjectPoints;
             }
             if (this->grade < 0) {
                this->grade = item->grade;
+               this->gradePolicyVersion = item->gradePolicyVersion;
             }
             return true;
          }
@@ -191,18 +582,23 @@ namespace OHARStudent {
    }
    
    bool StudentDataItem::operator == (const StudentDataItem & item) const {
-      return id == item.id;
+      return key == item.key;
    }
    
    bool StudentDataItem::operator != (const StudentDataItem & item) const {
-      return id != item.id;
+      return key != item.key;
+   }
+   
+   /** Orders students by their keys, see StudentKey for the order. */
+   bool StudentDataItem::operator < (const StudentDataItem & item) const {
+      return key < item.key;
    }
    
    
    std::ostream & operator << (std::ostream & ostr, const StudentDataItem & item) {
-      ostr << item.getId() << "\t" << item.getName() << "\t" << item.getStudyProgram()
-      << "\t" << item.getExamPoints() << "\t" << item.getExercisePointsTotal()
-      << "\t" << item.getCourseProjectPoints() << "\t" << item.getGrade() << std::endl;
+      StudentRecordFormatter formatter;
+      formatter.append(item);
+      ostr.write(formatter.data(), formatter.size());
       return ostr;
    }
    
@@ -237,6 +633,9 @@ namespace OHARStudent {
       if (student.getGrade() >= 0) {
          j["grade"] = student.getGrade();
       }
+      if (student.getGradePolicyVersion() > 0) {
+         j["gradepolicy"] = student.getGradePolicyVersion();
+      }
    }
    
    /**
@@ -266,6 +665,9 @@ namespace OHARStudent {
       if (j.find("grade") != j.end()) {
          student.setGrade(j.at("grade"));
       }
+      if (j.find("gradepolicy") != j.end()) {
+         student.setGradePolicyVersion(j.at("gradepolicy"));
+      }
    }
    
 } //namespace
@@ -0,0 +1,278 @@
+//
+//  StudentFileFollower.cpp
+//  PipesAndFiltersFramework
+//
+//  Created by Antti Juustila on 19.10.2026.
+//  Copyright (c) 2026 Antti Juustila. All rights reserved.
+//
+
+#include <algorithm>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <poll.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/inotify.h>
+#endif
+
+#include <g3log/g3log.hpp>
+
+#include <ProcessorNode/DataReaderObserver.h>
+
+#include <StudentNodeElements/StudentFileFollower.h>
+
+
+namespace OHARStudent {
+   
+   const std::string StudentFileFollower::TAG{"SFileFollower "};
+   
+   /**
+    Creates the follower. Reading starts when follow or readAppended is called.
+    @param observer The observer (handler) getting the student data read.
+    @param fileName The file to follow.
+    */
+   StudentFileFollower::StudentFileFollower(OHARBase::DataReaderObserver & observer, const std::string & fileName)
+   : observer(observer), fileName(fileName), reader(observer), fileFd(-1), offset(0), device(0), inode(0),
+   notifyFd(-1), fileWatch(-1)
+   {
+   }
+   
+   StudentFileFollower::~StudentFileFollower() {
+      closeFile();
+   }
+   
+   /** Sets lazy parsing of the rows on or off, see StudentFileReader::setLazyParsing.
+    @param lazy True to parse lazily. */
+   void StudentFileFollower::setLazyParsing(bool lazy) {
+      reader.setLazyParsing(lazy);
+   }
+   
+   /**
+    Reads the file and then follows it, until cancelled.
+    @param cancelled Set to true to stop following.
+    @param pollInterval How often the file is checked if no change notification arrives.
+    */
+   void StudentFileFollower::follow(const std::atomic<bool> & cancelled, std::chrono::milliseconds pollInterval) {
+      followAll(std::vector<StudentFileFollower*>(1, this), cancelled, pollInterval);
+   }
+   
+   /**
+    Reads the files and then follows them in the calling thread, until cancelled. The thread
+    sleeps until a file changes, and then reads the changed files only.
+    @param followers The followers of the files.
+    @param cancelled Set to true to stop following.
+    @param pollInterval How often all the files are checked if no change notification arrives.
+    */
+   void StudentFileFollower::followAll(const std::vector<StudentFileFollower*> & followers, const std::atomic<bool> & cancelled,
+                                       std::chrono::milliseconds pollInterval) {
+      int notifyFd = -1;
+      // The watch descriptor of each directory, with the followers of the files in it.
+      std::unordered_map<int, std::vector<StudentFileFollower*>> directoryWatches;
+#ifdef __linux__
+      notifyFd = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+      if (notifyFd >= 0) {
+         for (StudentFileFollower * follower : followers) {
+            // The directory is watched too, so that rotation (file replaced or recreated) is noticed.
+            const std::string & fileName = follower->fileName;
+            std::string::size_type slash = fileName.find_last_of('/');
+            std::string directory = slash == std::string::npos ? "." : (slash == 0 ? "/" : fileName.substr(0, slash));
+            const int directoryWatch = ::inotify_add_watch(notifyFd, directory.c_str(), IN_CREATE | IN_MOVED_TO);
+            if (directoryWatch < 0) {
+               LOG(WARNING) << TAG << "Cannot watch the directory " << directory << ", polling.";
+               continue;
+            }
+            directoryWatches[directoryWatch].push_back(follower);
+            follower->notifyFd = notifyFd;
+         }
+      } else {
+         LOG(WARNING) << TAG << "inotify not available, polling the files.";
+      }
+#endif
+      for (StudentFileFollower * follower : followers) {
+         follower->reader.setCancelFlag(&cancelled);
+         LOG(INFO) << TAG << "Following file " << follower->fileName;
+      }
+      std::vector<StudentFileFollower*> changed = followers;
+      while (!cancelled) {
+         for (StudentFileFollower * follower : changed) {
+            if (cancelled) {
+               break;
+            }
+            follower->readAppended();
+         }
+         changed.clear();
+         if (notifyFd < 0) {
+            std::this_thread::sleep_for(pollInterval);
+            changed = followers;
+            continue;
+         }
+#ifdef __linux__
+         struct pollfd pollFd = {notifyFd, POLLIN, 0};
+         if (::poll(&pollFd, 1, static_cast<int>(pollInterval.count())) <= 0) {
+            // Nothing noticed (or a file which could not be watched): check all the files.
+            changed = followers;
+            continue;
+         }
+         alignas(struct inotify_event) char events[4096];
+         ssize_t length = 0;
+         while ((length = ::read(notifyFd, events, sizeof(events))) > 0) {
+            for (char * position = events; position < events + length; ) {
+               const struct inotify_event * event = reinterpret_cast<const struct inotify_event*>(position);
+               auto directory = directoryWatches.find(event->wd);
+               if (directory != directoryWatches.end()) {
+                  changed.insert(changed.end(), directory->second.begin(), directory->second.end());
+               } else {
+                  for (StudentFileFollower * follower : followers) {
+                     if (follower->fileWatch == event->wd) {
+                        changed.push_back(follower);
+                     }
+                  }
+               }
+               position += sizeof(struct inotify_event) + event->len;
+            }
+         }
+         std::sort(changed.begin(), changed.end());
+         changed.erase(std::unique(changed.begin(), changed.end()), changed.end());
+#endif
+      }
+      for (StudentFileFollower * follower : followers) {
+         follower->fileWatch = -1;
+         follower->notifyFd = -1;
+         LOG(INFO) << TAG << "Stopped following file " << follower->fileName;
+      }
+      if (notifyFd >= 0) {
+         ::close(notifyFd);
+      }
+   }
+   
+   /**
+    Reads the complete lines appended to the file since the last call, and passes the
+    students parsed from them to the observer. A line without the ending newline is left
+    to be read when it is complete. If the file has been rotated, the rest of the old file
+    is read before the new file.
+    @returns The number of lines read.
+    */
+   std::size_t StudentFileFollower::readAppended() {
+      std::size_t lineCount = 0;
+      struct stat byName;
+      const bool exists = ::stat(fileName.c_str(), &byName) == 0;
+      if (fileFd >= 0 && exists && (byName.st_dev != device || byName.st_ino != inode)) {
+         // Rows written to the old file before it was replaced are not lost.
+         lineCount += readLines(true);
+         LOG(INFO) << TAG << "File " << fileName << " was rotated, reading the new file.";
+         closeFile();
+      }
+      if (fileFd < 0 && (!exists || !openFile())) {
+         return lineCount; // File does not exist (e.g. in the middle of rotation).
+      }
+      struct stat status;
+      if (::fstat(fileFd, &status) == 0 && static_cast<uint64_t>(status.st_size) < offset + partialLine.length()) {
+         LOG(INFO) << TAG << "File " << fileName << " was truncated, reading from the beginning.";
+         ::lseek(fileFd, 0, SEEK_SET);
+         restart();
+      }
+      return lineCount + readLines(false);
+   }
+   
+   /** @returns The offset of the first byte not yet consumed. */
+   uint64_t StudentFileFollower::getOffset() const {
+      return offset;
+   }
+   
+   /** Opens the file and reads it from the beginning. @returns True if the file was opened. */
+   bool StudentFileFollower::openFile() {
+      fileFd = ::open(fileName.c_str(), O_RDONLY | O_CLOEXEC);
+      if (fileFd < 0) {
+         return false;
+      }
+      struct stat status;
+      if (::fstat(fileFd, &status) == 0) {
+         device = status.st_dev;
+         inode = status.st_ino;
+      }
+      restart();
+      watchFile();
+      return true;
+   }
+   
+   void StudentFileFollower::closeFile() {
+      if (fileFd >= 0) {
+         ::close(fileFd);
+         fileFd = -1;
+      }
+   }
+   
+   /**
+    Reads the open file to its current end, passing the complete lines to the observer.
+    @param endOfFile True if nothing more will be written to the file, so a last line without
+    the newline is complete too.
+    @returns The number of lines read.
+    */
+   std::size_t StudentFileFollower::readLines(bool endOfFile) {
+      std::size_t lineCount = 0;
+      char buffer[64 * 1024];
+      ssize_t count = 0;
+      while ((count = ::read(fileFd, buffer, sizeof(buffer))) > 0) {
+         partialLine.append(buffer, static_cast<std::size_t>(count));
+         std::string::size_type begin = 0;
+         std::string::size_type newline = 0;
+         while ((newline = partialLine.find('\n', begin)) != std::string::npos) {
+            offset += newline - begin + 1;
+            lineCount += handleLine(partialLine.substr(begin, newline - begin));
+            begin = newline + 1;
+         }
+         partialLine.erase(0, begin);
+      }
+      if (endOfFile && !partialLine.empty()) {
+         offset += partialLine.length();
+         lineCount += handleLine(std::move(partialLine));
+         partialLine.clear();
+      }
+      return lineCount;
+   }
+   
+   /** Handles one line: the content type, or a student passed to the observer.
+    @returns 1 if the line was a student row, 0 otherwise. */
+   std::size_t StudentFileFollower::handleLine(std::string line) {
+      if (!line.empty() && line.back() == '\r') {
+         line.pop_back();
+      }
+      if (contentType.empty()) {
+         contentType = line;
+         return 0;
+      }
+      if (line.empty()) {
+         return 0;
+      }
+      std::unique_ptr<OHARBase::DataItem> item = reader.parseLine(line, contentType);
+      if (item) {
+         observer.handleNewItem(std::move(item));
+      }
+      return 1;
+   }
+   
+   /** Watches the open file for appended rows, replacing the watch of a previous (rotated) file. */
+   void StudentFileFollower::watchFile() {
+#ifdef __linux__
+      if (notifyFd < 0) {
+         return;
+      }
+      if (fileWatch >= 0) {
+         ::inotify_rm_watch(notifyFd, fileWatch);
+      }
+      fileWatch = ::inotify_add_watch(notifyFd, fileName.c_str(), IN_MODIFY);
+#endif
+   }
+   
+   void StudentFileFollower::restart() {
+      offset = 0;
+      partialLine.clear();
+      contentType.clear();
+   }
+   
+   
+} //namespace
@@ -6,11 +6,19 @@
 //  Copyright (c) 2014 Antti Juustila. All rights reserved.
 //
 
+#include <cctype>
+#include <charconv>
+#include <cstring>
+#include <fstream>
+#include <vector>
 
 #include <g3log/g3log.hpp>
 
 #include <StudentNodeElements/StudentFileReader.h>
 #include <StudentNodeElements/StudentDataItem.h>
+#include <StudentNodeElements/MetricsRegistry.h>
+#include <StudentNodeElements/StudentTracer.h>
+#include <StudentNodeElements/DelimiterScanner.h>
 
 
 namespace OHARStudent {
@@ -18,14 +26,177 @@ namespace OHARStudent {
    const std::string StudentFileReader::TAG{"SFileReader "};
    
    StudentFileReader::StudentFileReader(OHARBase::DataReaderObserver & obs)
-   : OHARBase::DataFileReader(obs) {
+   : OHARBase::DataFileReader(obs), cancelFlag(nullptr), lazyParsing(false),
+   parsedCount(MetricsRegistry::get().counter("StudentFileReader", "parsed")),
+   parseErrorCount(MetricsRegistry::get().counter("StudentFileReader", "parse_errors")),
+   allocationStage("StudentFileReader") {
       
    }
 
    StudentFileReader::~StudentFileReader() {
       
    }
+   
+   /** Sets the flag telling the reader to stop handling the file.
+    @param flag The cancellation flag, null if reading cannot be cancelled. */
+   void StudentFileReader::setCancelFlag(const std::atomic<bool> * flag) {
+      cancelFlag = flag;
+   }
     
+   /** Sets lazy parsing on or off. With lazy parsing, only the student id is parsed when
+    reading, and the other values when they are first needed (see StudentDataItem::parseLazily).
+    Invalid values are then logged when found, instead of the line being dropped when read.
+    @param lazy True to parse lazily. */
+   void StudentFileReader::setLazyParsing(bool lazy) {
+      lazyParsing = lazy;
+   }
+   
+   /**
+    Reads a student data file. The first line of the file is the content type, and the other lines
+    the records. The file is read in chunks; the tabs and newlines of each chunk are located at once
+    with DelimiterScanner, and the records are parsed from the located columns. A record longer than
+    a chunk grows the buffer. The students parsed are passed to the observer.
+    @param fileName The file to read.
+    @returns False if the file could not be opened.
+    */
+   bool StudentFileReader::readFile(const std::string & fileName) {
+      std::ifstream file(fileName, std::ios::binary);
+      if (!file.is_open()) {
+         LOG(WARNING) << TAG << "Could not open file " << fileName;
+         return false;
+      }
+      std::string contentType;
+      std::getline(file, contentType);
+      std::vector<char> buffer(ReadChunkSize);
+      std::size_t used = 0;
+      DelimiterScanner::Index index;
+      bool endOfFile = false;
+      while (!endOfFile && !(cancelFlag && cancelFlag->load())) {
+         if (used == buffer.size()) {
+            buffer.resize(buffer.size() * 2);
+         }
+         file.read(buffer.data() + used, static_cast<std::streamsize>(buffer.size() - used));
+         const std::size_t got = static_cast<std::size_t>(file.gcount());
+         endOfFile = got == 0 || !file;
+         used += got;
+         // The partial record left over from the previous chunk is at the start of the buffer,
+         // and is scanned again with the new bytes.
+         index.clear();
+         DelimiterScanner::scan(buffer.data(), used, index);
+         uint32_t recordBegin = 0;
+         std::size_t firstDelimiter = 0;
+         auto handleRecord = [&] (uint32_t recordEnd, std::size_t delimiterEnd) {
+            if (recordEnd > recordBegin && !(cancelFlag && cancelFlag->load())) {
+               std::unique_ptr<StudentDataItem> item = parseRecord(buffer.data(), recordBegin, recordEnd, index.delimiters.data() + firstDelimiter, delimiterEnd - firstDelimiter, contentType);
+               if (item) {
+                  observer.handleNewItem(std::move(item));
+               }
+            }
+         };
+         for (uint32_t recordEnd : index.recordEnds) {
+            const uint32_t newline = index.delimiters[recordEnd];
+            handleRecord(newline, recordEnd);
+            recordBegin = newline + 1;
+            firstDelimiter = recordEnd + 1;
+         }
+         if (endOfFile) {
+            // The last record has no newline after it.
+            handleRecord(static_cast<uint32_t>(used), index.delimiters.size());
+            recordBegin = static_cast<uint32_t>(used);
+         }
+         std::memmove(buffer.data(), buffer.data() + recordBegin, used - recordBegin);
+         used -= recordBegin;
+      }
+      return true;
+   }
+   
+   /**
+    Parses a record located by readFile.
+    @param buffer The buffer holding the record.
+    @param begin The offset of the record in the buffer.
+    @param end The offset of the newline (or the end of the data) after the record.
+    @param tabs The offsets of the tabs in the record, in the buffer.
+    @param tabCount The number of tabs in the record.
+    @param contentType Which kind of student data the record contains.
+    @returns The new student data item, or null if parsing fails.
+    */
+   std::unique_ptr<StudentDataItem> StudentFileReader::parseRecord(const char * buffer, uint32_t begin, uint32_t end, const uint32_t * tabs, std::size_t tabCount, const std::string & contentType) {
+      AllocationTag allocationTag(allocationStage);
+      TraceSpan span("parse");
+      std::unique_ptr<StudentDataItem> itemPtr;
+      if (!lazyParsing && contentType == "exercisedata") {
+         itemPtr = parseExercises(buffer, begin, end, tabs, tabCount);
+      } else {
+         std::vector<uint32_t> columnStarts;
+         columnStarts.reserve(tabCount + 1);
+         columnStarts.push_back(0);
+         for (std::size_t count = 0; count < tabCount; count++) {
+            columnStarts.push_back(tabs[count] + 1 - begin);
+         }
+         const std::string record(buffer + begin, end - begin);
+         LOG(INFO) << TAG << "Parsing string " << record.substr(0,15) << "...";
+         itemPtr = std::make_unique<StudentDataItem>();
+         bool parsed = false;
+         try {
+            parsed = lazyParsing ? itemPtr->parseLazily(record, contentType, std::move(columnStarts)) : itemPtr->parse(record, contentType, std::move(columnStarts));
+         } catch (const std::exception & e) {
+            LOG(WARNING) << TAG << "Invalid value in student data: " << e.what();
+         }
+         if (!parsed) {
+            LOG(WARNING) << TAG << "StudentDataItem failed to parse string!";
+            itemPtr.reset();
+         }
+      }
+      if (itemPtr) {
+         parsedCount.add();
+         span.setStudent(itemPtr.get());
+      } else {
+         parseErrorCount.add();
+      }
+      return itemPtr;
+   }
+   
+   /**
+    Parses an exercise record (id and the points of each exercise), converting the points
+    directly from the located columns into the points vector of the student.
+    @returns The new student data item, or null if a points value is not a number.
+    */
+   std::unique_ptr<StudentDataItem> StudentFileReader::parseExercises(const char * buffer, uint32_t begin, uint32_t end, const uint32_t * tabs, std::size_t tabCount) {
+      std::vector<int> points(tabCount);
+      for (std::size_t count = 0; count < tabCount; count++) {
+         const char * first = buffer + tabs[count] + 1;
+         const char * last = buffer + (count + 1 < tabCount ? tabs[count + 1] : end);
+         // Accepts what stoi accepts: leading white space, an explicit plus sign, and
+         // anything after the number (e.g. the \r of a Windows line end).
+         while (first < last && std::isspace(static_cast<unsigned char>(*first))) {
+            first++;
+         }
+         if (last - first > 1 && *first == '+' && std::isdigit(static_cast<unsigned char>(first[1]))) {
+            first++;
+         }
+         const std::from_chars_result result = std::from_chars(first, last, points[count]);
+         if (result.ec != std::errc()) {
+            LOG(WARNING) << TAG << "Invalid value in student data: " << std::string(first, last);
+            return nullptr;
+         }
+      }
+      std::unique_ptr<StudentDataItem> itemPtr = std::make_unique<StudentDataItem>();
+      itemPtr->setId(std::string(buffer + begin, buffer + (tabCount > 0 ? tabs[0] : end)));
+      itemPtr->setExercisePoints(points);
+      return itemPtr;
+   }
+   
+   /**
+    Parses one line of student data, read by some other means than the read method
+    (e.g. when following a file).
+    @param str The line of string to parse.
+    @param contentType Which kind of student data the line contains.
+    @returns The new student data item, or null if parsing fails.
+    */
+   std::unique_ptr<OHARBase::DataItem> StudentFileReader::parseLine(const std::string & str, const std::string & contentType) {
+      return parse(str, contentType);
+   }
+   
    /**
     Parses a string containing student data.
     @param str The line of string to parse, assuming to have student data items.
@@ -33,12 +204,27 @@ namespace OHARStudent {
     @returns The new student data item, or null if creation fails.
     */
    std::unique_ptr<OHARBase::DataItem> StudentFileReader::parse(const std::string & str, const std::string & contentType) {
+      if (cancelFlag && cancelFlag->load()) {
+         return nullptr;
+      }
+      AllocationTag allocationTag(allocationStage);
+      TraceSpan span("parse");
       std::unique_ptr<StudentDataItem> itemPtr = std::make_unique<StudentDataItem>();
       if (str.length() > 0) {
          LOG(INFO) << TAG << "Parsing string " << str.substr(0,15) << "...";
-         if (!itemPtr->parse(str, contentType)) {
+         bool parsed = false;
+         try {
+            parsed = lazyParsing ? itemPtr->parseLazily(str, contentType) : itemPtr->parse(str, contentType);
+         } catch (const std::exception & e) {
+            LOG(WARNING) << TAG << "Invalid value in student data: " << e.what();
+         }
+         if (parsed) {
+            parsedCount.add();
+            span.setStudent(itemPtr.get());
+         } else {
             LOG(WARNING) << TAG << "StudentDataItem failed to parse string!";
-            itemPtr.release();
+            parseErrorCount.add();
+            itemPtr.reset();
          }
       }
       return itemPtr;
@@ -0,0 +1,159 @@
+//
+//  StudentFileSet.cpp
+//  PipesAndFiltersFramework
+//
+//  Created by Antti Juustila on 19.10.2026.
+//  Copyright (c) 2026 Antti Juustila. All rights reserved.
+//
+
+#include <algorithm>
+#include <fstream>
+#include <memory>
+#include <thread>
+
+#include <glob.h>
+
+#include <boost/algorithm/string.hpp>
+
+#include <g3log/g3log.hpp>
+
+#include <StudentNodeElements/StudentFileSet.h>
+#include <StudentNodeElements/StudentFileReader.h>
+#include <StudentNodeElements/StudentFileFollower.h>
+
+
+namespace OHARStudent {
+   
+   const std::string StudentFileSet::TAG{"SFileSet "};
+   
+   /**
+    Expands the file specification to a list of files. The specification is a comma separated
+    list of file names or glob patterns. Names without glob characters are kept as they are,
+    even if the file does not exist (reading it then reports the error as before).
+    @param fileSpec The files to read, e.g. "students.txt,exams-*.txt".
+    @returns The file names, in the order given, patterns expanded in sorted order.
+    */
+   std::vector<std::string> StudentFileSet::expand(const std::string & fileSpec) {
+      std::vector<std::string> specs;
+      boost::split(specs, fileSpec, boost::is_any_of(","));
+      std::vector<std::string> files;
+      for (std::string & spec : specs) {
+         boost::trim(spec);
+         if (spec.empty()) {
+            continue;
+         }
+         if (spec.find_first_of("*?[") == std::string::npos) {
+            files.push_back(spec);
+            continue;
+         }
+         glob_t matches;
+         if (::glob(spec.c_str(), 0, nullptr, &matches) == 0) {
+            for (std::size_t index = 0; index < matches.gl_pathc; index++) {
+               files.push_back(matches.gl_pathv[index]);
+            }
+         } else {
+            LOG(WARNING) << TAG << "No files match " << spec;
+         }
+         ::globfree(&matches);
+      }
+      return files;
+   }
+   
+   /**
+    Reads the content type of a data file, from its first line.
+    @param file The data file.
+    @returns The content type, empty if the file could not be read.
+    */
+   std::string StudentFileSet::contentTypeOf(const std::string & file) {
+      std::ifstream in(file);
+      std::string contentType;
+      std::getline(in, contentType);
+      return contentType;
+   }
+   
+   /**
+    Checks that the files have the same content type. Files which cannot be read
+    (yet) are not checked; reading them reports the error.
+    @param files The files to check.
+    @returns True if all the readable files have the same content type.
+    */
+   bool StudentFileSet::haveSameContentType(const std::vector<std::string> & files) {
+      std::string expected;
+      for (const std::string & file : files) {
+         const std::string contentType = contentTypeOf(file);
+         if (contentType.empty()) {
+            continue;
+         }
+         if (expected.empty()) {
+            expected = contentType;
+         } else if (contentType != expected) {
+            LOG(WARNING) << TAG << "File " << file << " has content type " << contentType << ", other files have " << expected;
+            return false;
+         }
+      }
+      return true;
+   }
+   
+   /**
+    Reads the files into the observer, reading at most maxParallel files at the same time.
+    The observer's handleNewItem is called from several threads, so it must be thread safe.
+    @param observer The observer (handler) getting the student data read.
+    @param files The files to read.
+    @param maxParallel The maximum number of files read at the same time; zero or one reads the files one by one.
+    @param cancelFlag If set and true, reading is stopped. May be null.
+    @param lazyParsing If true, the students are parsed lazily (see StudentFileReader::setLazyParsing).
+    @returns The number of files read.
+    */
+   std::size_t StudentFileSet::readAll(OHARBase::DataReaderObserver & observer, const std::vector<std::string> & files, std::size_t maxParallel, const std::atomic<bool> * cancelFlag, bool lazyParsing) {
+      std::atomic<std::size_t> nextFile(0);
+      std::atomic<std::size_t> filesRead(0);
+      auto readFiles = [&] {
+         StudentFileReader reader(observer);
+         reader.setCancelFlag(cancelFlag);
+         reader.setLazyParsing(lazyParsing);
+         for (std::size_t index = nextFile++; index < files.size(); index = nextFile++) {
+            if (cancelFlag && cancelFlag->load()) {
+               break;
+            }
+            LOG(INFO) << TAG << "Reading file " << files[index];
+            reader.readFile(files[index]);
+            filesRead++;
+         }
+      };
+      std::size_t threadCount = std::min(std::max<std::size_t>(maxParallel, 1), files.size());
+      std::vector<std::thread> threads;
+      for (std::size_t count = 1; count < threadCount; count++) {
+         threads.emplace_back(readFiles);
+      }
+      // The calling thread reads files too.
+      readFiles();
+      for (std::thread & thread : threads) {
+         thread.join();
+      }
+      return filesRead;
+   }
+   
+   /**
+    Reads the files and then follows them, passing rows appended to the files to the observer,
+    until cancelled. The files are followed in the calling thread, which sleeps until one of
+    them changes (see StudentFileFollower::followAll).
+    @param observer The observer (handler) getting the student data read.
+    @param files The files to follow.
+    @param cancelled Set to true to stop following.
+    @param lazyParsing If true, the students are parsed lazily (see StudentFileReader::setLazyParsing).
+    */
+   void StudentFileSet::followAll(OHARBase::DataReaderObserver & observer, const std::vector<std::string> & files, const std::atomic<bool> & cancelled, bool lazyParsing) {
+      std::vector<std::unique_ptr<StudentFileFollower>> followers;
+      std::vector<StudentFileFollower*> following;
+      for (const std::string & file : files) {
+         followers.push_back(std::make_unique<StudentFileFollower>(observer, file));
+         followers.back()->setLazyParsing(lazyParsing);
+         following.push_back(followers.back().get());
+      }
+      if (!following.empty()) {
+         StudentFileFollower::followAll(following, cancelled);
+      }
+   }
+   
+   
+} //namespace
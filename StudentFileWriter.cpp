@@ -7,11 +7,13 @@
 //
 
 #include <chrono>
+#include <sstream>
 
 #include <g3log/g3log.hpp>
 
 #include <StudentNodeElements/StudentFileWriter.h>
 #include <StudentNodeElements/StudentDataItem.h>
+#include <StudentNodeElements/CompressedOutput.h>
 
 
 namespace OHARStudent {
@@ -19,24 +21,41 @@ namespace OHARStudent {
     
     /** The constructor initializes the object as well as writes the
      header into the file, adding to whatever is already there.
+     By default, a file name ending with ".gz" is written compressed in gzip format,
+     and ".zz" in zlib format. The text written is the same as into an uncompressed file.
+     A zlib file can hold only one compressed stream, so it is replaced instead of added to.
+     If the library was built without zlib, a compressed file is not opened at all, rather than
+     writing plain text into a file named as compressed.
      @param fileName The file name where to write the student data.
+     @param compression Whether to compress the file, by default chosen by the file name extension.
      */
-    StudentFileWriter::StudentFileWriter(const std::string & fileName) {
+    StudentFileWriter::StudentFileWriter(const std::string & fileName, Compression compression) {
         using std::chrono::system_clock;
         if (fileName.length() > 0) {
+            if (compression == Compression::ByExtension) {
+                compression = compressionFor(fileName);
+            }
             LOG(INFO) << "Opening file " << fileName << " for writing.";
-            file.open(fileName, std::ofstream::out | std::ofstream::app);
-            if (file.is_open()) {
+            if (compression != Compression::None && !CompressedOutput::isAvailable()) {
+                LOG(WARNING) << "Built without zlib, cannot write the compressed file " << fileName;
+            } else if (compression == Compression::None) {
+                file.open(fileName, std::ofstream::out | std::ofstream::app);
+            } else {
+                compressed = std::make_unique<CompressedOutput>(fileName, compression == Compression::Gzip ? CompressedOutput::Format::Gzip : CompressedOutput::Format::Zlib);
+            }
+            if (isOpen()) {
                 LOG(INFO) << "Succeeded, start writing";
                 system_clock::time_point today = system_clock::now();
                 std::time_t tt;
                 tt = system_clock::to_time_t ( today );
-                file << std::endl << std::endl;
-                file << "** Welcome to student register system" << std::endl;
-                file << "** (c) Antti Juustila, 2014-2019. University of Oulu, Finland." << std::endl;
-                file << "** Today is: " << ctime(&tt) << std::endl;
-                file << "** Following grades have been awarded:" << std::endl;
-                file << "ID\tName\t\tDept\tExam\tExerc\tWork\tGRADE" << std::endl;
+                std::ostringstream header;
+                header << std::endl << std::endl;
+                header << "** Welcome to student register system" << std::endl;
+                header << "** (c) Antti Juustila, 2014-2019. University of Oulu, Finland." << std::endl;
+                header << "** Today is: " << ctime(&tt) << std::endl;
+                header << "** Following grades have been awarded:" << std::endl;
+                header << "ID\tName\t\tDept\tExam\tExerc\tWork\tGRADE" << std::endl;
+                output(header.str());
             } else {
                 LOG(WARNING) << "Could not open the output file.";
             }
@@ -45,21 +64,93 @@ namespace OHARStudent {
         }
     }
     
-    /** The destructor writes the ending statements to the file and closes it. */
+    /** The destructor writes the buffered records and the ending statements to the file and closes it. */
     StudentFileWriter::~StudentFileWriter() {
-        file << std::endl << "**==--> End of batch <--==**" << std::endl;
+        flush();
+        output("\n**==--> End of batch <--==**\n");
+        bool closed = true;
         if (file.is_open()) {
             file.close();
+            closed = !file.fail();
+        }
+        if (compressed) {
+            closed = compressed->close();
+        }
+        if (closed) {
+            LOG(INFO) << "Closing output file.";
+        } else {
+            LOG(WARNING) << "Could not write the output file completely.";
         }
-        LOG(INFO) << "Closing output file.";
     }
     
-    /** The method writes the student data into the file using the operator <<().
+    /** Chooses the compression by the file name extension.
+     @param fileName The file name.
+     @returns Gzip for ".gz", Zlib for ".zz", None otherwise. */
+    StudentFileWriter::Compression StudentFileWriter::compressionFor(const std::string & fileName) {
+        auto endsWith = [&fileName] (const std::string & extension) {
+            return fileName.length() > extension.length()
+                && fileName.compare(fileName.length() - extension.length(), extension.length(), extension) == 0;
+        };
+        if (endsWith(".gz")) {
+            return Compression::Gzip;
+        } else if (endsWith(".zz")) {
+            return Compression::Zlib;
+        }
+        return Compression::None;
+    }
+    
+    /** @returns True if the output file is open. */
+    bool StudentFileWriter::isOpen() const {
+        return file.is_open() || (compressed && compressed->isOpen());
+    }
+    
+    /** The method writes the student data into the file. The records are formatted into a buffer
+     which is written to the file in chunks of WriteChunkSize bytes, and when flush is called.
      @param student The student data to write into the file.
      */
     void StudentFileWriter::write(const StudentDataItem * student) {
-        if (file.is_open() && student != nullptr) {
-            file << *student;
+        if (isOpen() && student != nullptr) {
+            std::lock_guard<std::mutex> guard(bufferGuard);
+            formatter.append(*student);
+            if (formatter.size() >= WriteChunkSize) {
+                writeBuffer();
+            }
+        }
+    }
+    
+    /** Writes the buffered records into the file and flushes the file. A compressed
+     file is flushed so that the records written so far can be decompressed.
+     @returns False if the file is not open, or writing or compressing has failed. */
+    bool StudentFileWriter::flush() {
+        std::lock_guard<std::mutex> guard(bufferGuard);
+        writeBuffer();
+        bool flushed = false;
+        if (compressed) {
+            flushed = compressed->flush();
+        } else if (file.is_open()) {
+            flushed = file.flush().good();
+        }
+        if (!flushed && isOpen()) {
+            LOG(WARNING) << "Could not write the output file.";
+        }
+        return flushed;
+    }
+    
+    /** Writes the buffered records into the file. Call with bufferGuard locked. */
+    void StudentFileWriter::writeBuffer() {
+        if (formatter.size() > 0) {
+            output(std::string_view(formatter.data(), formatter.size()));
+            formatter.clear();
+        }
+    }
+    
+    /** Writes text into the file, or queues it for compression into the file.
+     @param text The text to write. */
+    void StudentFileWriter::output(std::string_view text) {
+        if (compressed) {
+            compressed->write(text.data(), text.length());
+        } else if (file.is_open()) {
+            file.write(text.data(), text.length());
         }
     }
     
@@ -6,6 +6,7 @@
 //  Copyright (c) 2014 Antti Juustila. All rights reserved.
 //
 
+#include <algorithm>
 #include <sstream>
 
 #include <g3log/g3log.hpp>
@@ -16,6 +17,12 @@
 #include <StudentNodeElements/StudentHandler.h>
 #include <StudentNodeElements/StudentDataItem.h>
 #include <StudentNodeElements/StudentFileReader.h>
+#include <StudentNodeElements/StudentFileSet.h>
+#include <StudentNodeElements/ReaderExecutor.h>
+#include <StudentNodeElements/StudentCheckpointer.h>
+#include <StudentNodeElements/StudentIngestQueue.h>
+#include <StudentNodeElements/MetricsRegistry.h>
+#include <StudentNodeElements/StudentTracer.h>
 
 
 namespace OHARStudent {
@@ -23,16 +30,135 @@ namespace OHARStudent {
    const std::string StudentHandler::TAG{"StudentHandler "};
    
    StudentHandler::StudentHandler(OHARBase::ProcessorNode & myNode)
-   : node(myNode)
+   : node(myNode), metricsName(MetricsRegistry::get().instanceName("StudentHandler")), readerFlow(metricsName), maxParallelFiles(4), followFiles(false),
+   filesRead(false), previousNodeEnded(false),
+   consumedCount(MetricsRegistry::get().counter(metricsName, "consumed")),
+   mergedCount(MetricsRegistry::get().counter(metricsName, "merged")),
+   heldCount(MetricsRegistry::get().gauge(metricsName, "held")),
+   consumeTime(MetricsRegistry::get().histogram(metricsName, "consume")),
+   allocationStage(metricsName),
+   status(myNode, "StudentHandler", "handler"),
+   reader(TAG)
    {
+      // Cancelling the reading wakes up the reader thread waiting for flow control credits.
+      reader.setCancelListener([this] { readerFlow.wakeWaiters(); });
    }
    
    StudentHandler::~StudentHandler() {
    }
    
+   /**
+    Sets how many data files are read at the same time, when the data file configuration
+    of the node lists several files.
+    @param maxFiles The maximum number of files read concurrently.
+    */
+   void StudentHandler::setMaxParallelFiles(std::size_t maxFiles) {
+      maxParallelFiles = maxFiles;
+   }
+   
+   /**
+    Sets the follow mode. In follow mode, the data files are not read just once, but
+    followed like "tail -f": rows appended to the files are read and passed on as they
+    are written, until cancelFileRead is called or the handler is destroyed.
+    @param follow True to follow the data files.
+    */
+   void StudentHandler::setFollowMode(bool follow) {
+      followFiles = follow;
+   }
+   
+   /**
+    Waits until the data file has been read, if reading is pending or going on.
+    @param timeout How long to wait at most.
+    @returns True if the file is not being read anymore.
+    */
+   bool StudentHandler::waitForFileRead(std::chrono::milliseconds timeout) {
+      const auto deadline = std::chrono::steady_clock::now() + timeout;
+      if (!reader.waitForCompletion(timeout)) {
+         return false;
+      }
+      if (ingestQueue) {
+         // The students read are handled when the merge thread has drained the queue.
+         auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+         return ingestQueue->waitUntilDrained(std::max(remaining, std::chrono::milliseconds(0)));
+      }
+      return true;
+   }
+   
+   /** Cancels reading the data file, if reading is pending or going on. */
+   void StudentHandler::cancelFileRead() {
+      reader.cancel();
+   }
+   
+   /**
+    Sets how many progress updates per second are shown at most in the node's UI. The
+    updates summarize the students received, merged and held so far.
+    @param maxUpdatesPerSecond The maximum number of updates per second.
+    */
+   void StudentHandler::setMaxStatusUpdates(unsigned maxUpdatesPerSecond) {
+      status.setMaxUpdatesPerSecond(maxUpdatesPerSecond);
+   }
+   
+   /**
+    Sets the maximum number of items read from the data file which can be in flight in
+    the following handlers. When the limit is reached, the file reading thread waits until
+    items have been handled. By default the reading is not limited.
+    @param maxItems The maximum number of items in flight, zero for no limit.
+    */
+   void StudentHandler::setMaxItemsInFlight(std::size_t maxItems) {
+      readerFlow.setMaxInFlight(maxItems);
+   }
+   
+   /**
+    Enables writing checkpoints of the held students into a local snapshot file. If the
+    file already exists (node was restarted in the middle of a run), the students held
+    at the time of the last checkpoint are first restored into the handler, so that the
+    data already received from the previous node or the data file need not be sent again.
+    The checkpoint records the source of each held student, so a restored student only joins
+    with data from the other source; the same data arriving again is combined into it.
+    Call this before the handler starts receiving data.
+    @param fileName The snapshot file.
+    @param interval How often the changes in the held students are written to the file.
+    */
+   void StudentHandler::enableCheckpoints(const std::string & fileName, std::chrono::milliseconds interval) {
+      if (ingestQueue) {
+         LOG(WARNING) << TAG << "Checkpoints must be enabled before the ingest queue, not enabled.";
+         return;
+      }
+      std::lock_guard<std::mutex> guard(listGuard);
+      checkpointer = std::make_unique<StudentCheckpointer>(fileName, interval);
+      for (StudentCheckpointer::Restored & restored : checkpointer->restore()) {
+         StudentKey key = restored.first->getKey();
+         dataItems[key] = HeldStudent{std::move(restored.first), restored.second};
+      }
+      checkpointer->start();
+      heldCount.set(dataItems.size());
+      status.setHeld(dataItems.size());
+      node.showUIMessage("Restored " + std::to_string(dataItems.size()) + " students from checkpoint.");
+      node.updatePackageCountInQueue("handler", dataItems.size());
+   }
+   
+   /**
+    Enables the ingest queue. The students received from the network or read from the data files
+    are then pushed into a lock free queue, and a merge thread owned by the handler merges them
+    with the held students and passes the merged students to the next handlers. The receiving
+    threads thus never wait for the lock of the held students, and the merge thread needs no lock.
+    Incoming data packages are always consumed; the merged students are passed on by the merge
+    thread. Call this before the handler starts receiving data, after enableCheckpoints if
+    checkpoints are used.
+    */
+   void StudentHandler::enableIngestQueue() {
+      if (ingestQueue) {
+         return;
+      }
+      ingestQueue = std::make_unique<StudentIngestQueue>(metricsName, [this] (std::unique_ptr<StudentDataItem> student, StudentSource source) {
+         mergeStudent(std::move(student), source);
+      });
+   }
+   
    /** Reads student data from an input file, using StudentFileReader.
     The file name to read data from is gotten from the ProcessorNode, which
-    has the input file name as a configuration item. That file is then read.
+    has the input file name as a configuration item. That file is then read. The configuration
+    item may also list several files or glob patterns, separated by commas (see StudentFileSet).
     Note that PlainStudentFileHandler has similar functionality. It is used in Nodes
     which do not need StudentHandler (no merging of student object is needed), but
     student data files still need to be read and handled.
@@ -43,17 +169,76 @@ namespace OHARStudent {
       // in the context of the incomingHandlerThread -- effectively stopping the handling of other
       // packages waiting in the network interface, until file is read. Or, if the command is executed in the context of
       // command handler thread, then other commands cannot be handled until file has been read -- if the
-      // file to read is very large, this could take seconds/tens of seconds. So, start a new thread when the file
-      // is read, to let the other thread continue the work it needs to do.
-      // This would be an issue only with very large files, so if optimization would be required, change the code below
-      // so that first, check the size of the file and if it is small then execute file reading without a thread.
-      // If it is large, then do as below, read the file in a thread.
-      std::thread( [this] {
-         StudentFileReader reader(*this);
-         using namespace std::chrono_literals;
-         std::this_thread::sleep_for(50ms);
-         reader.read(node.getDataFileName());
-      }).detach();
+      // file to read is very large, this could take seconds/tens of seconds. So, the file is read in the
+      // reader executor thread owned by this handler, to let the other thread continue the work it needs to do.
+      // The executor starts reading when consume has finished handling the command, and ignores the
+      // request if the file is already being read.
+      // The data file configuration may list several files (or glob patterns); those are read
+      // concurrently, at most maxParallelFiles at the same time.
+      // In follow mode the files are read and then followed, passing on rows appended to them,
+      // until reading is cancelled. Readfile commands arriving meanwhile are then ignored.
+      // The files must have the same content type: a student is passed on when its file row
+      // joins the network data, so rows from a second kind of file would arrive too late.
+      const std::size_t parallelFiles = maxParallelFiles;
+      const bool follow = followFiles;
+      reader.submit( [this, parallelFiles, follow] (const std::atomic<bool> & cancelled) {
+         std::vector<std::string> files = StudentFileSet::expand(node.getDataFileName());
+         if (!StudentFileSet::haveSameContentType(files)) {
+            LOG(WARNING) << TAG << "Data files have different content types, not reading them.";
+            node.showUIMessage("Data files must have the same content type, files not read.");
+            return;
+         }
+         if (follow) {
+            StudentFileSet::followAll(*this, files, cancelled);
+         } else {
+            StudentFileSet::readAll(*this, files, parallelFiles, &cancelled);
+            if (!cancelled && inputEnded(true)) {
+               passEndOfBatch();
+            }
+         }
+         // Show the final counts, the last updates may have been skipped due to rate limiting.
+         status.publish();
+      });
+   }
+   
+   /**
+    Records the end of one of the inputs of the batch: the data files have been read, or the
+    previous node has passed on the end of its batch ("flush" control package). The batch ends
+    when both inputs have ended, since only then no more students can join.
+    @param files True if the data files have been read, false if the previous node has ended.
+    @returns True if the batch has now ended; the flags are then reset for the next batch.
+    */
+   bool StudentHandler::inputEnded(bool files) {
+      std::lock_guard<std::mutex> guard(batchGuard);
+      (files ? filesRead : previousNodeEnded) = true;
+      if (filesRead && previousNodeEnded) {
+         filesRead = false;
+         previousNodeEnded = false;
+         return true;
+      }
+      return false;
+   }
+   
+   /**
+    Passes a "flush" control package to the next handlers when the batch has ended, telling the
+    handlers collecting students (e.g. StudentOrderingHandler) that all the students of the batch
+    have been passed on. Students still held then have no data from the other source, and are
+    left waiting for the next batch.
+    */
+   void StudentHandler::passEndOfBatch() {
+      // The students joined before the end are handled when the merge thread has drained the queue.
+      while (ingestQueue && !ingestQueue->waitUntilDrained(std::chrono::milliseconds(100))) {
+      }
+      const int64_t unmatched = heldCount.get();
+      if (unmatched > 0) {
+         LOG(WARNING) << TAG << "End of the batch, " << unmatched << " students still held without data from the other source.";
+         node.showUIMessage("End of the batch: " + std::to_string(unmatched) + " students without data from the other source.");
+      }
+      LOG(INFO) << TAG << "Data files read and the previous node ended, passing on the end of the batch.";
+      OHARBase::Package endOfBatch;
+      endOfBatch.setType(OHARBase::Package::Control);
+      endOfBatch.setPayload(std::string("flush"));
+      node.passToNextHandlers(this, endOfBatch);
    }
    
    /**
@@ -70,37 +255,68 @@ namespace OHARStudent {
     not be done. Returns false if package should be handled by following DataHandlers.
     */
    bool StudentHandler::consume(OHARBase::Package & data) {
+      AllocationTag allocationTag(allocationStage);
       bool retval = false; // didn't consume, or if consumed, still pass to next handler.
       if (data.getType() == OHARBase::Package::Data) {
          OHARBase::DataItem * item = data.getPayloadObject();
          if (item) {
             StudentDataItem * newStudent = dynamic_cast<StudentDataItem*>(item);
             if (newStudent) {
-               node.showUIMessage("Got student data for " + newStudent->getName());
-               LOG(INFO) << TAG << "Consuming data from network";
-               // Since several threads can call handlers' consume at the
-               // same time, must use a mutex to guard multithreaded access to the list.
-               // Lock will be released when the guard variable goes out of scope (leaving the if block).
-               std::lock_guard<std::mutex> guard(listGuard);
-               StudentDataItem * containerStudent = findStudent(*newStudent);
-               if (containerStudent) {
-                  LOG(INFO) << TAG << "Student data at node merged now with incoming. " << containerStudent->getName();
-                  node.showUIMessage("Found local student data, merging with received data.");
-                  newStudent->addFrom(*containerStudent);
-                  dataItems.remove(containerStudent);
-                  delete containerStudent;
-               } else {
-                  node.showUIMessage("No local data for this student, waiting for it");
-                  dataItems.push_back(newStudent->clone().release());
-                  LOG(INFO) << TAG << "No matching student data from file yet, hold it in container with " << dataItems.size()+1 << " elements";
-                  retval = true; // consumed the item and keeping it until additional data found.
+               if (ingestQueue) {
+                  consumedCount.add();
+                  status.received();
+                  ingestQueue->push(std::make_unique<StudentDataItem>(*newStudent), StudentSource::Network, FlowCredit::takeCurrent());
+                  return true;
                }
-               node.updatePackageCountInQueue("handler", dataItems.size());
-            } // guard lock released here.
+               ScopedLatency timer(consumeTime);
+               TraceSpan span("join", newStudent);
+               consumedCount.add();
+               status.received();
+               LOG(INFO) << TAG << "Consuming data from network";
+               {
+                  // Since several threads can call handlers' consume at the
+                  // same time, must use a mutex to guard multithreaded access to the list.
+                  // Lock will be released when the guard variable goes out of scope (leaving the block).
+                  std::lock_guard<std::mutex> guard(listGuard);
+                  HeldStudent * held = findStudent(*newStudent);
+                  if (held && held->source == StudentSource::Network) {
+                     // Same student from the network again, still waiting for the file data.
+                     combineHeld(*held, *newStudent);
+                     retval = true;
+                  } else if (held) {
+                     LOG(INFO) << TAG << "Student data at node merged now with incoming. " << held->student->getName();
+                     status.merged();
+                     newStudent->addFrom(*held->student);
+                     dataItems.erase(newStudent->getKey());
+                     mergedCount.add();
+                     if (checkpointer) {
+                        checkpointer->studentReleased(newStudent->getKey());
+                     }
+                  } else {
+                     dataItems.emplace(newStudent->getKey(), HeldStudent{std::make_unique<StudentDataItem>(*newStudent), StudentSource::Network});
+                     if (checkpointer) {
+                        checkpointer->studentHeld(*newStudent, StudentSource::Network);
+                     }
+                     LOG(INFO) << TAG << "No matching student data from file yet, hold it in container with " << dataItems.size()+1 << " elements";
+                     retval = true; // consumed the item and keeping it until additional data found.
+                  }
+                  heldCount.set(dataItems.size());
+                  status.setHeld(dataItems.size());
+               } // guard lock released here.
+               status.publishIfDue();
+            }
          }
       } else if (data.getType() == OHARBase::Package::Control) {
          if (data.getPayloadString() == "readfile") {
+            ReaderExecutor::ReadyGate readyWhenHandled(reader);
             readFile();
+         } else if (data.getPayloadString() == "flush") {
+            // The end of the batch of the previous node. In follow mode the files do not end, so
+            // the batches are those of the previous node.
+            if (followFiles || inputEnded(false)) {
+               passEndOfBatch();
+            }
+            retval = true; // This handler passes on its own end of the batch.
          }
       }
       return retval; // false: pass to next handler. true: do not pass to next handler.
@@ -114,54 +330,138 @@ namespace OHARStudent {
     @param item The data item read from the file.
     */
    void StudentHandler::handleNewItem(std::unique_ptr<OHARBase::DataItem> item) {
+      AllocationTag allocationTag(allocationStage);
+      // Wait until there is room downstream for one more item, or reading is cancelled.
+      FlowCredit credit = readerFlow.acquire(&reader.getCancelFlag());
+      if (!credit.isValid()) {
+         LOG(INFO) << TAG << "Reading cancelled, item dropped.";
+         return;
+      }
+      FlowCredit::Scope creditScope(credit);
       // Check if the item is already in the container.
       LOG(INFO) << TAG << "One new data item from file";
       StudentDataItem * newStudent = dynamic_cast<StudentDataItem*>(item.get());
-      if (newStudent) {
-         node.showUIMessage("Student data read from file for " + newStudent->getName());
-         // Since several threads can call handlers' consume at the
-         // same time, must use a mutex to guard multithreaded access to the list.
-         // Lock will be released when the guard variable goes out of scope (leaving the if block).
-         std::lock_guard<std::mutex> guard(listGuard);
-         StudentDataItem * containerStudent = findStudent(*newStudent);
-         if (containerStudent) {
-            node.showUIMessage("Had received same student data from previous node, combining.");
-            LOG(INFO) << TAG << "Student already in container, combine and pass on! " << containerStudent->getName();
-            newStudent->addFrom(*containerStudent);
-            OHARBase::Package package;
-            package.setType(OHARBase::Package::Data);
-            package.setPayload(std::move(item));
-            dataItems.remove(containerStudent);
-            delete containerStudent;
-            LOG(INFO) << "METRICS students in handler: " << dataItems.size();
+      if (newStudent && ingestQueue) {
+         consumedCount.add();
+         status.received();
+         item.release();
+         ingestQueue->push(std::unique_ptr<StudentDataItem>(newStudent), StudentSource::File, std::move(credit));
+      } else if (newStudent) {
+         ScopedLatency timer(consumeTime);
+         TraceSpan span("join", newStudent);
+         consumedCount.add();
+         status.received();
+         // A joined student is passed on after the lock has been released.
+         OHARBase::Package package;
+         bool joined = false;
+         {
+            // Since several threads can call handlers' consume at the
+            // same time, must use a mutex to guard multithreaded access to the list.
+            // Lock will be released when the guard variable goes out of scope (leaving the block).
+            std::lock_guard<std::mutex> guard(listGuard);
+            HeldStudent * held = findStudent(*newStudent);
+            if (held && held->source == StudentSource::File) {
+               // Same student from the files again (e.g. re-read after a restart), still waiting for the network data.
+               combineHeld(*held, *newStudent);
+            } else if (held) {
+               status.merged();
+               LOG(INFO) << TAG << "Student already in container, combine and pass on! " << held->student->getName();
+               newStudent->addFrom(*held->student);
+               package.setType(OHARBase::Package::Data);
+               package.setPayload(std::move(item));
+               joined = true;
+               dataItems.erase(newStudent->getKey());
+               mergedCount.add();
+               heldCount.set(dataItems.size());
+               if (checkpointer) {
+                  checkpointer->studentReleased(newStudent->getKey());
+               }
+            } else {
+               LOG(INFO) << TAG << "No matching student data from network, hold it in container. " << newStudent->getName();
+               dataItems.emplace(newStudent->getKey(), HeldStudent{std::unique_ptr<StudentDataItem>(newStudent), StudentSource::File});
+               item.release();
+               heldCount.set(dataItems.size());
+               if (checkpointer) {
+                  checkpointer->studentHeld(*newStudent, StudentSource::File);
+               }
+            }
+            status.setHeld(dataItems.size());
+         } // guard lock goes out of scope here and is released.
+         if (joined) {
             node.passToNextHandlers(this, package);
-         } else {
-            node.showUIMessage("Have not yet got data for this student from previous node, holding data.");
-            node.showUIMessage("Holding " + std::to_string(dataItems.size()+1) + " students now.");
-            LOG(INFO) << TAG << "No matching student data from network, hold it in container. " << newStudent->getName();
-            dataItems.push_back(newStudent);
-            item.release();
-            LOG(INFO) << "METRICS students in handler: " << dataItems.size();
          }
-         node.updatePackageCountInQueue("handler", dataItems.size());
-      } // guard lock goes out of scope here and is released.
-      LOG(INFO) << TAG << "Container holds " << dataItems.size()+1 << " students.";
+         status.publishIfDue();
+      }
       
    }
    
+   /**
+    Merges a student with the held students, in the merge thread of the ingest queue. Only the
+    merge thread uses the held students when the queue is enabled, so no lock is needed.
+    @param newStudent The student received from the network or read from a file.
+    @param source Where the student came from.
+    */
+   void StudentHandler::mergeStudent(std::unique_ptr<StudentDataItem> newStudent, StudentSource source) {
+      AllocationTag allocationTag(allocationStage);
+      ScopedLatency timer(consumeTime);
+      TraceSpan span("join", newStudent.get());
+      auto iter = dataItems.find(newStudent->getKey());
+      if (iter != dataItems.end() && iter->second.source == source) {
+         combineHeld(iter->second, *newStudent);
+      } else if (iter != dataItems.end()) {
+         status.merged();
+         LOG(INFO) << TAG << "Student data merged in the merge thread. " << iter->second.student->getName();
+         newStudent->addFrom(*iter->second.student);
+         dataItems.erase(iter);
+         mergedCount.add();
+         heldCount.set(dataItems.size());
+         status.setHeld(dataItems.size());
+         if (checkpointer) {
+            checkpointer->studentReleased(newStudent->getKey());
+         }
+         OHARBase::Package package;
+         package.setType(OHARBase::Package::Data);
+         package.setPayload(std::move(newStudent));
+         node.passToNextHandlers(this, package);
+      } else {
+         LOG(INFO) << TAG << "No matching student data yet, merge thread holds it. " << newStudent->getName();
+         if (checkpointer) {
+            checkpointer->studentHeld(*newStudent, source);
+         }
+         StudentKey key = newStudent->getKey();
+         dataItems.emplace(key, HeldStudent{std::move(newStudent), source});
+         heldCount.set(dataItems.size());
+         status.setHeld(dataItems.size());
+      }
+      status.publishIfDue();
+   }
+   
    /** Finds a student from the container, if one exists.
     @param which The student to search for.
-    @returns A pointer to the student in the container, null if student was not found.
+    @returns A pointer to the held student in the container, null if student was not found.
     */
-   StudentDataItem * StudentHandler::findStudent(const StudentDataItem & which) const {
-      for (std::list<OHARBase::DataItem*>::const_iterator iter = dataItems.begin(); iter != dataItems.end(); iter++) {
-         StudentDataItem * containerStudent = dynamic_cast<StudentDataItem*>(*iter);
-         if (which == *containerStudent) {
-            return containerStudent;
-         }
+   StudentHandler::HeldStudent * StudentHandler::findStudent(const StudentDataItem & which) {
+      auto iter = dataItems.find(which.getKey());
+      if (iter != dataItems.end()) {
+         return &iter->second;
       }
       return nullptr;
    }
    
+   /**
+    Combines a student arriving again from the source of a held student into the held student.
+    The held student keeps its values and gets the ones it is missing, and keeps waiting for
+    the data from the other source. Called while holding the lock, or in the merge thread.
+    @param held The held student.
+    @param newStudent The student arrived from the same source.
+    */
+   void StudentHandler::combineHeld(HeldStudent & held, const StudentDataItem & newStudent) {
+      LOG(INFO) << TAG << "Student arrived again from the same source, combined into the held one. " << held.student->getName();
+      held.student->addFrom(newStudent);
+      if (checkpointer) {
+         checkpointer->studentHeld(*held.student, held.source);
+      }
+   }
+   
    
 } //namespace
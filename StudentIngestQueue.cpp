@@ -0,0 +1,177 @@
+//
+//  StudentIngestQueue.cpp
+//  PipesAndFiltersFramework
+//
+//  Created by Antti Juustila on 19.10.2026.
+//  Copyright (c) 2026 Antti Juustila. All rights reserved.
+//
+
+#include <StudentNodeElements/StudentIngestQueue.h>
+#include <StudentNodeElements/StudentDataItem.h>
+#include <StudentNodeElements/MetricsRegistry.h>
+
+
+namespace OHARStudent {
+   
+   /**
+    Creates the queue and starts the merge thread.
+    @param handlerName The handler the "ingest_queue" size gauge is reported for.
+    @param consumer Handles the students in the merge thread.
+    */
+   StudentIngestQueue::StudentIngestQueue(const std::string & handlerName, Consumer consumer)
+   : consumer(std::move(consumer)), head(&stub), tail(&stub), pushedCount(0), consumedCount(0),
+   drainTarget(NoDrainTarget), mergeThreadIdle(false), stopping(false),
+   sizeGauge(MetricsRegistry::get().gauge(handlerName, "ingest_queue"))
+   {
+      mergeThread = std::thread(&StudentIngestQueue::run, this);
+   }
+   
+   /** Consumes the students still in the queue and stops the merge thread. */
+   StudentIngestQueue::~StudentIngestQueue() {
+      {
+         std::lock_guard<std::mutex> guard(idleGuard);
+         stopping = true;
+      }
+      pushed.notify_one();
+      if (mergeThread.joinable()) {
+         mergeThread.join();
+      }
+   }
+   
+   /**
+    Pushes a student to be handled by the merge thread. Never waits for the merge thread,
+    unless the merge thread is idle and needs to be woken up.
+    @param student The student.
+    @param source Where the student came from, passed to the consumer.
+    @param credit The flow control credit of the student, released after the student has been handled.
+    */
+   void StudentIngestQueue::push(std::unique_ptr<StudentDataItem> student, StudentSource source, FlowCredit credit) {
+      Node * node = new Node;
+      node->student = std::move(student);
+      node->source = source;
+      node->credit = std::move(credit);
+      const uint64_t size = ++pushedCount - consumedCount.load(std::memory_order_relaxed);
+      sizeGauge.set(static_cast<int64_t>(size));
+      pushNode(node);
+      // Sequentially consistent with the merge thread setting the flag and then checking
+      // the head, so either the producer sees the thread idle, or the thread sees the node.
+      if (mergeThreadIdle.load()) {
+         std::lock_guard<std::mutex> guard(idleGuard);
+         pushed.notify_one();
+      }
+   }
+   
+   /**
+    Waits until the merge thread has handled all the students pushed so far. Students pushed
+    while waiting are not waited for, so this returns also when new students keep coming.
+    @param timeout How long to wait at most.
+    @returns True if the queue was drained.
+    */
+   bool StudentIngestQueue::waitUntilDrained(std::chrono::milliseconds timeout) {
+      const uint64_t target = pushedCount.load();
+      const auto deadline = std::chrono::steady_clock::now() + timeout;
+      std::unique_lock<std::mutex> lock(idleGuard);
+      while (consumedCount.load() < target) {
+         // Registered under the lock; the merge thread notifies when it has consumed this many.
+         if (target < drainTarget.load()) {
+            drainTarget.store(target);
+         }
+         if (consumedCount.load() >= target) {
+            break;
+         }
+         if (drained.wait_until(lock, deadline) == std::cv_status::timeout) {
+            return consumedCount.load() >= target;
+         }
+      }
+      return true;
+   }
+   
+   /** @returns The number of students pushed but not yet handled. */
+   std::size_t StudentIngestQueue::getSize() const {
+      const uint64_t consumed = consumedCount.load();
+      return static_cast<std::size_t>(pushedCount.load() - consumed);
+   }
+   
+   void StudentIngestQueue::pushNode(Node * node) {
+      node->next.store(nullptr, std::memory_order_relaxed);
+      Node * previous = head.exchange(node);
+      // Between the exchange and this store the node is not reachable from the tail yet;
+      // the merge thread sees the queue as not empty and waits for the link.
+      previous->next.store(node, std::memory_order_release);
+   }
+   
+   /**
+    Pops the next node (intrusive MPSC queue by Dmitry Vyukov). Only called by the merge thread.
+    @returns The node, or null if the queue is empty or a producer has not linked its node yet.
+    */
+   StudentIngestQueue::Node * StudentIngestQueue::pop() {
+      Node * first = tail;
+      Node * next = first->next.load(std::memory_order_acquire);
+      if (first == &stub) {
+         if (!next) {
+            return nullptr;
+         }
+         tail = next;
+         first = next;
+         next = next->next.load(std::memory_order_acquire);
+      }
+      if (next) {
+         tail = next;
+         return first;
+      }
+      if (first != head.load()) {
+         return nullptr;
+      }
+      // The last node: put the stub behind it, so that the node can be taken out.
+      pushNode(&stub);
+      next = first->next.load(std::memory_order_acquire);
+      if (next) {
+         tail = next;
+         return first;
+      }
+      return nullptr;
+   }
+   
+   /** @returns True if nothing has been pushed after the stub. Only called by the merge thread. */
+   bool StudentIngestQueue::isEmpty() const {
+      return tail == &stub && head.load() == &stub;
+   }
+   
+   /** The merge thread, handling the students until the queue is destroyed. */
+   void StudentIngestQueue::run() {
+      while (true) {
+         Node * node = pop();
+         if (node) {
+            {
+               FlowCredit::Scope creditScope(node->credit);
+               consumer(std::move(node->student), node->source);
+            }
+            delete node;
+            // Sequentially consistent with a waiter setting its target and then checking the
+            // count, so either the waiter sees the count, or this thread sees the target.
+            if (++consumedCount >= drainTarget.load()) {
+               std::lock_guard<std::mutex> guard(idleGuard);
+               drainTarget.store(NoDrainTarget);
+               drained.notify_all();
+            }
+            continue;
+         }
+         if (!isEmpty()) {
+            // A producer is between swapping the head and linking its node.
+            std::this_thread::yield();
+            continue;
+         }
+         std::unique_lock<std::mutex> lock(idleGuard);
+         sizeGauge.set(0);
+         drained.notify_all();
+         mergeThreadIdle = true;
+         if (isEmpty() && stopping) {
+            break;
+         }
+         pushed.wait(lock, [this] { return !isEmpty() || stopping; });
+         mergeThreadIdle = false;
+      }
+   }
+   
+   
+} //namespace
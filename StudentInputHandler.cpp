@@ -13,6 +13,7 @@
 
 #include <StudentNodeElements/StudentInputHandler.h>
 #include <StudentNodeElements/StudentDataItem.h>
+#include <StudentNodeElements/MetricsRegistry.h>
 
 namespace OHARStudent {
 	
@@ -20,6 +21,11 @@ namespace OHARStudent {
 	
 	/** Default constructor, does nothing. */
 	StudentInputHandler::StudentInputHandler()
+	: metricsName(MetricsRegistry::get().instanceName("StudentInputHandler")),
+	consumedCount(MetricsRegistry::get().counter(metricsName, "consumed")),
+	parseErrorCount(MetricsRegistry::get().counter(metricsName, "parse_errors")),
+	consumeTime(MetricsRegistry::get().histogram(metricsName, "consume")),
+	allocationStage(metricsName)
 	{
 	}
 	
@@ -32,7 +38,7 @@ namespace OHARStudent {
 	 need to be parsed. The StudentDataItem knows how to parse the data.
 	 Calling StudentDataItem::parse goes through the string and sets
 	 the values parsed form the string to the student data item member
-	 varibles. This student data item is then stored in the Package::dataItem
+	 varibles (lazily, when the values are first needed). This student data item is then stored in the Package::dataItem
 	 pointer. Now the Package contains both the raw data from the network as
 	 well as the parsed, structured data in the student data object. The latter
 	 is more useful in manipulating student data in application classes.
@@ -42,14 +48,27 @@ namespace OHARStudent {
 	 change to use the package also.
 	 */
 	bool StudentInputHandler::consume(OHARBase::Package & data) {
+		AllocationTag allocationTag(allocationStage);
 		using namespace OHARBase;
 		if (data.getType() == Package::Data && data.getPayloadString().length() > 0) {
          LOG(INFO) << TAG << "** data received, handling! **";
+         ScopedLatency timer(consumeTime);
+         consumedCount.add();
 			// parse data to a student data object
-         nlohmann::json j = nlohmann::json::parse(data.getPayloadString());
-         std::unique_ptr<StudentDataItem> item = std::make_unique<StudentDataItem>(j.get<OHARStudent::StudentDataItem>());
-         
-         data.setPayload(std::move(item));
+         // Only the id is parsed now; other fields are decoded when first needed, and the
+         // original JSON can be sent on as is if the student is not modified in this node.
+         try {
+            std::unique_ptr<StudentDataItem> item = std::make_unique<StudentDataItem>();
+            if (item->parseJsonLazily(data.getPayloadString())) {
+               data.setPayload(std::move(item));
+            } else {
+               parseErrorCount.add();
+               LOG(WARNING) << TAG << "No student id in the package";
+            }
+         } catch (const nlohmann::json::exception & e) {
+            parseErrorCount.add();
+            LOG(WARNING) << TAG << "Could not parse student data from the package: " << e.what();
+         }
 		}
 		return false; // Always let others handle this data package too.
 	}
@@ -0,0 +1,115 @@
+//
+//  StudentKey.cpp
+//  PipesAndFiltersFramework
+//
+//  Created by Antti Juustila on 19.10.2026.
+//  Copyright (c) 2026 Antti Juustila. All rights reserved.
+//
+
+#include <StudentNodeElements/StudentKey.h>
+
+
+namespace OHARStudent {
+   
+   namespace {
+      const uint64_t NumericFlag = uint64_t(1) << 63;
+      const int DigitCountShift = 59;
+      const uint64_t ValueMask = (uint64_t(1) << DigitCountShift) - 1;
+   }
+   
+   /** Creates an empty (string) key. */
+   StudentKey::StudentKey()
+   : packed(0)
+   {
+   }
+   
+   /** Creates a key from the student id. If the id contains only digits and
+    is not longer than MaxDigits, the id is packed into an integer. Otherwise the
+    id is stored as a string.
+    @param id The student id.
+    */
+   StudentKey::StudentKey(const std::string & id)
+   : packed(0)
+   {
+      const std::size_t length = id.length();
+      if (length > 0 && length <= MaxDigits) {
+         uint64_t value = 0;
+         for (char c : id) {
+            if (c < '0' || c > '9') {
+               fallback = id;
+               return;
+            }
+            value = value * 10 + static_cast<uint64_t>(c - '0');
+         }
+         // Digit count is included so that ids with leading zeros stay distinct.
+         packed = NumericFlag | (uint64_t(length) << DigitCountShift) | value;
+      } else {
+         fallback = id;
+      }
+   }
+   
+   bool StudentKey::isNumeric() const {
+      return packed != 0;
+   }
+   
+   /** @returns The packed integer key, or zero if the key is not numeric. */
+   uint64_t StudentKey::getPacked() const {
+      return packed;
+   }
+   
+   /** Converts the key back to the original id string.
+    @returns The student id the key was created from.
+    */
+   std::string StudentKey::toString() const {
+      if (!isNumeric()) {
+         return fallback;
+      }
+      int digits = static_cast<int>((packed & ~NumericFlag) >> DigitCountShift);
+      uint64_t value = packed & ValueMask;
+      std::string result(digits, '0');
+      for (int index = digits - 1; index >= 0 && value > 0; index--) {
+         result[index] = static_cast<char>('0' + value % 10);
+         value /= 10;
+      }
+      return result;
+   }
+   
+   std::size_t StudentKey::hash() const {
+      if (isNumeric()) {
+         // Mix the bits (splitmix64 finalizer) since sequential ids are common.
+         uint64_t x = packed;
+         x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+         x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+         x = x ^ (x >> 31);
+         return static_cast<std::size_t>(x);
+      }
+      // FNV-1a rather than std::hash, so the value (and the partition of the student) is the
+      // same in every process, whatever standard library it was built with.
+      uint64_t hash = 0xcbf29ce484222325ULL;
+      for (unsigned char byte : fallback) {
+         hash ^= byte;
+         hash *= 0x100000001b3ULL;
+      }
+      return static_cast<std::size_t>(hash);
+   }
+   
+   bool StudentKey::operator == (const StudentKey & other) const {
+      return packed == other.packed && (isNumeric() || fallback == other.fallback);
+   }
+   
+   bool StudentKey::operator != (const StudentKey & other) const {
+      return !(*this == other);
+   }
+   
+   bool StudentKey::operator < (const StudentKey & other) const {
+      if (isNumeric() && other.isNumeric()) {
+         return packed < other.packed;
+      }
+      if (isNumeric() != other.isNumeric()) {
+         return isNumeric(); // Numeric keys are ordered before string keys.
+      }
+      return fallback < other.fallback;
+   }
+   
+   
+} //namespace
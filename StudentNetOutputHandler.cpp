@@ -14,6 +14,8 @@
 
 #include <StudentNodeElements/StudentNetOutputHandler.h>
 #include <StudentNodeElements/StudentDataItem.h>
+#include <StudentNodeElements/MetricsRegistry.h>
+#include <StudentNodeElements/StudentTracer.h>
 
 
 namespace OHARStudent {
@@ -21,6 +23,10 @@ namespace OHARStudent {
    const std::string StudentNetOutputHandler::TAG{"SNetOutputHandler "};
    
     StudentNetOutputHandler::StudentNetOutputHandler()
+    : metricsName(MetricsRegistry::get().instanceName("StudentNetOutputHandler")),
+    encodedCount(MetricsRegistry::get().counter(metricsName, "encoded")),
+    consumeTime(MetricsRegistry::get().histogram(metricsName, "consume")),
+    allocationStage(metricsName)
     {
     }
     
@@ -36,6 +42,7 @@ namespace OHARStudent {
      @return Returns false to indicate that the package can be further handled by (possible) other handlers.
      */
     bool StudentNetOutputHandler::consume(OHARBase::Package & data) {
+        AllocationTag allocationTag(allocationStage);
         LOG(INFO) << TAG << "Converting the payload from object to JSON";
         if (data.getType() == OHARBase::Package::Data) {
             OHARBase::DataItem * item = data.getPayloadObject();
@@ -44,12 +51,22 @@ namespace OHARStudent {
                 const StudentDataItem * student = dynamic_cast<const StudentDataItem*>(item);
                 // ...and it was a student data item object...
                 if (student) {
+                    ScopedLatency timer(consumeTime);
+                    TraceSpan span("encode", student);
+                    encodedCount.add();
                     // ...put the data into a JSON string payload...
-                    LOG(INFO) << TAG << "Student is converted to JSON... " << student->getName();
-                    nlohmann::json j = *student;
-                    std::string payload = j.dump();
-                    // ... set it as the data for the Package...
-                    data.setPayload(payload);
+                    const std::string * sourceJson = student->getSourceJson();
+                    if (sourceJson) {
+                        // ...which is the JSON the student arrived in, if it was not modified in this node...
+                        LOG(INFO) << TAG << "Student passed on in the original JSON... " << student->getId();
+                        data.setPayload(*sourceJson);
+                    } else {
+                        LOG(INFO) << TAG << "Student is converted to JSON... " << student->getName();
+                        nlohmann::json j = *student;
+                        std::string payload = j.dump();
+                        // ... set it as the data for the Package...
+                        data.setPayload(payload);
+                    }
                 }
             }
         }
@@ -4,5 +4,7 @@ find_dependency(Boost 1.70.0)
 find_dependency(g3log)
 find_dependency(nlohmann_json 3.2.0)
 find_dependency(ProcessorNode)
+# Optional, needed if the library was built with zlib for compressed output.
+find_package(ZLIB QUIET)
 
 include("${CMAKE_CURRENT_LIST_DIR}/StudentNodeElementsTargets.cmake")
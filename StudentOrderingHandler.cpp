@@ -0,0 +1,378 @@
+//
+//  StudentOrderingHandler.cpp
+//  PipesAndFiltersFramework
+//
+//  Created by Antti Juustila on 19.10.2026.
+//  Copyright (c) 2026 Antti Juustila. All rights reserved.
+//
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <queue>
+
+#include <unistd.h>
+
+#include <g3log/g3log.hpp>
+#include <nlohmann/json.hpp>
+
+#include <ProcessorNode/ProcessorNode.h>
+#include <ProcessorNode/Package.h>
+
+#include <StudentNodeElements/StudentOrderingHandler.h>
+#include <StudentNodeElements/StudentDataItem.h>
+#include <StudentNodeElements/MetricsRegistry.h>
+
+
+namespace OHARStudent {
+   
+   const std::string StudentOrderingHandler::TAG{"SOrderingHandler "};
+   
+   namespace {
+      /** Orders students by key; ties keep their arrival order when used with a stable sort. */
+      bool keyLess(const std::unique_ptr<StudentDataItem> & first, const std::unique_ptr<StudentDataItem> & second) {
+         return *first < *second;
+      }
+   }
+   
+   /**
+    Reads the students from a sorted run file, one at a time (see writeRecord). The run ends
+    at the end of the file; if it ends anywhere else (the file could not be opened, a record is
+    truncated or invalid), the reader has failed and the rest of the run is lost.
+    */
+   class StudentOrderingHandler::RunReader {
+   public:
+      explicit RunReader(const std::string & fileName) : fileName(fileName), file(fileName, std::ios::binary), failed(false) {
+         if (!file.is_open()) {
+            LOG(WARNING) << TAG << "Could not open the run file " << fileName;
+            failed = true;
+            return;
+         }
+         next();
+      }
+      /** @returns The current student, null when the run has ended. */
+      std::unique_ptr<StudentDataItem> & current() {
+         return student;
+      }
+      /** @returns True if the run ended before the end of the file. */
+      bool hasFailed() const {
+         return failed;
+      }
+      const std::string & getFileName() const {
+         return fileName;
+      }
+      /** Reads the next student into current. */
+      void next() {
+         student.reset();
+         if (failed) {
+            return;
+         }
+         unsigned char lengthBytes[4];
+         if (!file.read(reinterpret_cast<char*>(lengthBytes), sizeof(lengthBytes))) {
+            if (file.gcount() != 0 || !file.eof()) {
+               fail("truncated record length");
+            }
+            return;
+         }
+         uint32_t length = lengthBytes[0] | (lengthBytes[1] << 8) | (lengthBytes[2] << 16) | (static_cast<uint32_t>(lengthBytes[3]) << 24);
+         std::vector<uint8_t> payload(length);
+         if (!file.read(reinterpret_cast<char*>(payload.data()), length)) {
+            fail("truncated record");
+            return;
+         }
+         try {
+            student = std::make_unique<StudentDataItem>(nlohmann::json::from_cbor(payload).get<StudentDataItem>());
+         } catch (const nlohmann::json::exception & e) {
+            fail(e.what());
+         }
+      }
+   private:
+      void fail(const std::string & reason) {
+         LOG(WARNING) << TAG << "Run file " << fileName << " could not be read to the end: " << reason;
+         failed = true;
+      }
+      std::string fileName;
+      std::ifstream file;
+      std::unique_ptr<StudentDataItem> student;
+      bool failed;
+   };
+   
+   /**
+    Creates the handler.
+    @param myNode The node where the handler is.
+    @param memoryBudget How many bytes of students are held in memory before they are written into a run file.
+    @param spillDirectory The directory for the run files, by default the temporary directory.
+    */
+   StudentOrderingHandler::StudentOrderingHandler(OHARBase::ProcessorNode & myNode, std::size_t memoryBudget, const std::string & spillDirectory)
+   : node(myNode), memoryBudget(memoryBudget), spillDirectory(spillDirectory), bufferedBytes(0), runsWritten(0),
+   metricsName(MetricsRegistry::get().instanceName("StudentOrderingHandler")),
+   bufferedCount(MetricsRegistry::get().gauge(metricsName, "buffered")),
+   spilledRuns(MetricsRegistry::get().counter(metricsName, "spilled_runs")),
+   releasedCount(MetricsRegistry::get().counter(metricsName, "released")),
+   allocationStage(metricsName)
+   {
+      if (this->spillDirectory.empty()) {
+         std::error_code error;
+         this->spillDirectory = std::filesystem::temp_directory_path(error).string();
+         if (error) {
+            this->spillDirectory = ".";
+         }
+      }
+   }
+   
+   /** Keeps the students not flushed: the students in memory are written into one more run
+    file, and the run files are left in the spill directory, with an error logged for each.
+    The students are not passed on here, since the handlers following this one may already
+    be destroyed. */
+   StudentOrderingHandler::~StudentOrderingHandler() {
+      std::lock_guard<std::mutex> runLock(runGuard);
+      std::vector<std::unique_ptr<StudentDataItem>> inMemory;
+      {
+         std::lock_guard<std::mutex> guard(bufferGuard);
+         inMemory.swap(students);
+      }
+      const std::size_t unflushed = inMemory.size();
+      if (!inMemory.empty()) {
+         spill(std::move(inMemory));
+      }
+      if (!students.empty()) {
+         LOG(WARNING) << TAG << "Destroyed before flushing, " << students.size() << " students could not be written and are lost.";
+      }
+      if (!runFiles.empty()) {
+         LOG(WARNING) << TAG << "Destroyed before flushing, the students not passed on (" << unflushed
+            << " of them in memory) are kept in " << runFiles.size() << " run files:";
+         for (const std::string & runFile : runFiles) {
+            LOG(WARNING) << TAG << "Kept run file " << runFile;
+         }
+      }
+   }
+   
+   /**
+    Holds a student package until the handler is flushed. A "flush" control package
+    flushes the handler.
+    @param data The package.
+    @returns True for student packages, which are passed on later in order. False for other packages.
+    */
+   bool StudentOrderingHandler::consume(OHARBase::Package & data) {
+      AllocationTag allocationTag(allocationStage);
+      if (data.getType() == OHARBase::Package::Data) {
+         const StudentDataItem * student = dynamic_cast<const StudentDataItem*>(data.getPayloadObject());
+         if (student) {
+            std::unique_ptr<StudentDataItem> held = std::make_unique<StudentDataItem>(*student);
+            const std::size_t size = estimateSize(*held);
+            std::vector<std::unique_ptr<StudentDataItem>> full;
+            {
+               std::lock_guard<std::mutex> guard(bufferGuard);
+               students.push_back(std::move(held));
+               bufferedBytes += size;
+               if (bufferedBytes > memoryBudget) {
+                  full.swap(students);
+                  bufferedBytes = 0;
+               }
+               bufferedCount.set(students.size());
+            }
+            if (!full.empty()) {
+               // Written outside bufferGuard, so other threads can keep adding students meanwhile.
+               std::lock_guard<std::mutex> guard(runGuard);
+               spill(std::move(full));
+            }
+            return true;
+         }
+      } else if (data.getType() == OHARBase::Package::Control) {
+         if (data.getPayloadString() == "flush") {
+            flush();
+         }
+      }
+      return false;
+   }
+   
+   /**
+    Passes the held students to the next handlers, sorted by the student key. Students arriving
+    meanwhile are held until the next flush.
+    */
+   void StudentOrderingHandler::flush() {
+      std::lock_guard<std::mutex> runLock(runGuard);
+      std::vector<std::unique_ptr<StudentDataItem>> inMemory;
+      {
+         std::lock_guard<std::mutex> guard(bufferGuard);
+         inMemory.swap(students);
+         bufferedBytes = 0;
+         bufferedCount.set(0);
+      }
+      if (inMemory.empty() && runFiles.empty()) {
+         return;
+      }
+      std::stable_sort(inMemory.begin(), inMemory.end(), keyLess);
+      std::vector<std::unique_ptr<RunReader>> runs;
+      for (const std::string & runFile : runFiles) {
+         runs.push_back(std::make_unique<RunReader>(runFile));
+      }
+      LOG(INFO) << TAG << "Merging " << inMemory.size() << " students in memory with " << runs.size() << " run files.";
+      mergeRuns(runs, inMemory, [this] (std::unique_ptr<StudentDataItem> student) {
+         OHARBase::Package package;
+         package.setType(OHARBase::Package::Data);
+         package.setPayload(std::move(student));
+         releasedCount.add();
+         node.passToNextHandlers(this, package);
+      });
+      for (const std::unique_ptr<RunReader> & run : runs) {
+         if (run->hasFailed()) {
+            // The students read from it have been passed on; the rest are only in the file.
+            LOG(WARNING) << TAG << "Students were lost from the run file " << run->getFileName() << ", the file is kept.";
+            node.showUIMessage("Ordering: could not read all students from " + run->getFileName());
+         } else {
+            std::remove(run->getFileName().c_str());
+         }
+      }
+      runs.clear();
+      runFiles.clear();
+   }
+   
+   /**
+    The k-way merge of sorted runs: the heap holds the run numbers ordered by the next student
+    of each run, the students in memory being the last run. Ties are broken by the run number,
+    earlier runs first, so students with the same key keep their order.
+    @param runs The run files to merge.
+    @param inMemory Sorted students in memory, merged as one more run.
+    @param emit Called with each student, in order.
+    @returns True if all the runs were read to their end.
+    */
+   bool StudentOrderingHandler::mergeRuns(std::vector<std::unique_ptr<RunReader>> & runs, std::vector<std::unique_ptr<StudentDataItem>> & inMemory,
+                                          const std::function<void(std::unique_ptr<StudentDataItem>)> & emit) {
+      const std::size_t memoryRun = runs.size();
+      std::size_t memoryIndex = 0;
+      auto head = [&] (std::size_t run) -> std::unique_ptr<StudentDataItem> & {
+         return run == memoryRun ? inMemory[memoryIndex] : runs[run]->current();
+      };
+      auto later = [&] (std::size_t first, std::size_t second) {
+         const StudentDataItem & firstStudent = *head(first);
+         const StudentDataItem & secondStudent = *head(second);
+         if (firstStudent == secondStudent) {
+            return first > second;
+         }
+         return secondStudent < firstStudent;
+      };
+      std::priority_queue<std::size_t, std::vector<std::size_t>, decltype(later)> heap(later);
+      for (std::size_t run = 0; run < runs.size(); run++) {
+         if (runs[run]->current()) {
+            heap.push(run);
+         }
+      }
+      if (!inMemory.empty()) {
+         heap.push(memoryRun);
+      }
+      while (!heap.empty()) {
+         const std::size_t run = heap.top();
+         heap.pop();
+         std::unique_ptr<StudentDataItem> student = std::move(head(run));
+         if (run == memoryRun) {
+            if (++memoryIndex < inMemory.size()) {
+               heap.push(run);
+            }
+         } else {
+            runs[run]->next();
+            if (runs[run]->current()) {
+               heap.push(run);
+            }
+         }
+         emit(std::move(student));
+      }
+      for (const std::unique_ptr<RunReader> & run : runs) {
+         if (run->hasFailed()) {
+            return false;
+         }
+      }
+      return true;
+   }
+   
+   /** Sorts the students and writes them into a new run file. When there are MaxRunFiles
+    run files, they are merged into one, so that the final merge does not need to open too
+    many files. Call with runGuard locked.
+    @param full The students to write. */
+   void StudentOrderingHandler::spill(std::vector<std::unique_ptr<StudentDataItem>> full) {
+      std::stable_sort(full.begin(), full.end(), keyLess);
+      const std::string fileName = nextRunFileName();
+      std::ofstream file(fileName, std::ios::binary | std::ios::trunc);
+      for (const std::unique_ptr<StudentDataItem> & student : full) {
+         writeRecord(file, *student);
+      }
+      file.close();
+      if (!file) {
+         // Keep the students rather than lose them; they are then held in memory.
+         LOG(WARNING) << TAG << "Could not write the run file " << fileName << ", keeping the students in memory.";
+         std::remove(fileName.c_str());
+         std::lock_guard<std::mutex> guard(bufferGuard);
+         for (std::unique_ptr<StudentDataItem> & student : full) {
+            students.push_back(std::move(student));
+         }
+         bufferedCount.set(students.size());
+         return;
+      }
+      runFiles.push_back(fileName);
+      spilledRuns.add();
+      LOG(INFO) << TAG << "Wrote " << full.size() << " students to run file " << fileName;
+      if (runFiles.size() >= MaxRunFiles) {
+         mergeRunFiles();
+      }
+   }
+   
+   /** Merges the run files into one run file. Call with runGuard locked. */
+   void StudentOrderingHandler::mergeRunFiles() {
+      const std::string fileName = nextRunFileName();
+      std::ofstream file(fileName, std::ios::binary | std::ios::trunc);
+      std::vector<std::unique_ptr<RunReader>> runs;
+      for (const std::string & runFile : runFiles) {
+         runs.push_back(std::make_unique<RunReader>(runFile));
+      }
+      std::vector<std::unique_ptr<StudentDataItem>> none;
+      const bool allRead = mergeRuns(runs, none, [&file] (std::unique_ptr<StudentDataItem> student) {
+         writeRecord(file, *student);
+      });
+      runs.clear();
+      file.close();
+      if (!file || !allRead) {
+         // The runs are still there and are merged when flushed.
+         LOG(WARNING) << TAG << "Could not merge the run files into " << fileName << ", keeping the original run files.";
+         std::remove(fileName.c_str());
+         return;
+      }
+      for (const std::string & runFile : runFiles) {
+         std::remove(runFile.c_str());
+      }
+      LOG(INFO) << TAG << "Merged " << runFiles.size() << " run files into " << fileName;
+      runFiles.assign(1, fileName);
+   }
+   
+   /** @returns The name for the next run file, unique to this process and handler. */
+   std::string StudentOrderingHandler::nextRunFileName() {
+      return spillDirectory + "/sne-run-" + std::to_string(getpid()) + "-"
+         + std::to_string(reinterpret_cast<uintptr_t>(this)) + "-" + std::to_string(runsWritten++) + ".tmp";
+   }
+   
+   /** Writes one student into a run file: the length of the student (4 bytes, little endian)
+    followed by the student in CBOR. */
+   void StudentOrderingHandler::writeRecord(std::ostream & file, const StudentDataItem & student) {
+      std::vector<uint8_t> payload = nlohmann::json::to_cbor(nlohmann::json(student));
+      const uint32_t length = static_cast<uint32_t>(payload.size());
+      const unsigned char lengthBytes[4] = {
+         static_cast<unsigned char>(length), static_cast<unsigned char>(length >> 8),
+         static_cast<unsigned char>(length >> 16), static_cast<unsigned char>(length >> 24)
+      };
+      file.write(reinterpret_cast<const char*>(lengthBytes), sizeof(lengthBytes));
+      file.write(reinterpret_cast<const char*>(payload.data()), payload.size());
+   }
+   
+   /** @returns Rough estimate of the memory a held student takes. */
+   std::size_t StudentOrderingHandler::estimateSize(const StudentDataItem & student) {
+      std::size_t size = sizeof(StudentDataItem) + student.getId().capacity() + student.getName().capacity()
+         + student.getStudyProgram().capacity() + student.getExercisePoints().capacity() * sizeof(int);
+      if (const std::string * json = student.getSourceJson()) {
+         size += json->capacity();
+      }
+      return size;
+   }
+   
+   
+} //namespace
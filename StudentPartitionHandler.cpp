@@ -0,0 +1,168 @@
+//
+//  StudentPartitionHandler.cpp
+//  PipesAndFiltersFramework
+//
+//  Created by Antti Juustila on 19.10.2026.
+//  Copyright (c) 2026 Antti Juustila. All rights reserved.
+//
+
+#include <algorithm>
+
+#include <g3log/g3log.hpp>
+
+#include <ProcessorNode/Package.h>
+#include <ProcessorNode/ProcessorNode.h>
+
+#include <StudentNodeElements/StudentPartitionHandler.h>
+#include <StudentNodeElements/StudentDataItem.h>
+#include <StudentNodeElements/StudentKey.h>
+#include <StudentNodeElements/MetricsRegistry.h>
+#include <StudentNodeElements/PackageWorkerPool.h>
+
+
+namespace OHARStudent {
+   
+   const std::string StudentPartitionHandler::TAG{"SPartitionHandler "};
+   
+   /** How often (in routed students) the skew gauge is updated. */
+   static const uint64_t SkewUpdateInterval = 1024;
+   
+   /**
+    Creates the handler and starts the delivery threads of the replicas.
+    @param replicas The replicas, one per partition. The nodes and handlers must outlive this handler.
+    */
+   StudentPartitionHandler::StudentPartitionHandler(const std::vector<Replica> & replicas)
+   : replicas(replicas),
+   metricsName(MetricsRegistry::get().instanceName("StudentPartitionHandler")),
+   routedCount(MetricsRegistry::get().counter(metricsName, "routed")),
+   skewPercent(MetricsRegistry::get().gauge(metricsName, "skew_percent")),
+   allocationStage(metricsName)
+   {
+      for (std::size_t partition = 0; partition < replicas.size(); partition++) {
+         partitionCounts.push_back(&MetricsRegistry::get().counter(metricsName, "partition_" + std::to_string(partition)));
+         const Replica replica = replicas[partition];
+         deliveries.push_back(std::make_unique<PackageWorkerPool>(1, true,
+            [replica] (OHARBase::Package & package) {
+               if (!replica.firstHandler->consume(package)) {
+                  replica.node->passToNextHandlers(replica.firstHandler, package);
+               }
+               return false; // Delivered, nothing to emit.
+            },
+            [] (OHARBase::Package &) {}));
+      }
+      if (replicas.empty()) {
+         LOG(WARNING) << TAG << "No replicas, students are passed on unpartitioned.";
+      }
+   }
+   
+   /** Delivers the packages still queued and stops the delivery threads. */
+   StudentPartitionHandler::~StudentPartitionHandler() {
+      deliveries.clear();
+   }
+   
+   /** Waits until the packages routed so far have been delivered to the replicas. */
+   void StudentPartitionHandler::drain() {
+      for (std::unique_ptr<PackageWorkerPool> & delivery : deliveries) {
+         delivery->drain();
+      }
+   }
+   
+   /**
+    Routes a student package to the replica of the student's partition. Control packages
+    are given to all replicas.
+    @param data The package to route.
+    @returns True if the student was routed, so the package is not handled further in this node.
+    False for other packages, and if there are no replicas.
+    */
+   bool StudentPartitionHandler::consume(OHARBase::Package & data) {
+      AllocationTag allocationTag(allocationStage);
+      if (replicas.empty()) {
+         return false;
+      }
+      if (data.getType() == OHARBase::Package::Control) {
+         // Through the queues, so the replicas see the control in order with the data.
+         for (std::unique_ptr<PackageWorkerPool> & delivery : deliveries) {
+            OHARBase::Package copy;
+            copy.setType(OHARBase::Package::Control);
+            copy.setPayload(data.getPayloadString());
+            delivery->submit(std::move(copy), FlowCredit());
+         }
+         return false;
+      }
+      if (data.getType() == OHARBase::Package::Data) {
+         const StudentDataItem * student = dynamic_cast<const StudentDataItem*>(data.getPayloadObject());
+         if (!student) {
+            LOG(WARNING) << TAG << "No student object in the package, cannot partition it.";
+            return false;
+         }
+         const std::size_t partition = partitionFor(student->getKey());
+         partitionCounts[partition]->add();
+         routedCount.add();
+         if (routedCount.get() % SkewUpdateInterval == 0) {
+            skewPercent.set(static_cast<int64_t>(getSkew() * 100.0));
+         }
+         // The student stays in flight until the replica has handled it.
+         deliveries[partition]->submit(std::move(data), FlowCredit::takeCurrent());
+         return true;
+      }
+      return false;
+   }
+   
+   /** @returns The number of partitions (replicas). */
+   std::size_t StudentPartitionHandler::getPartitionCount() const {
+      return replicas.size();
+   }
+   
+   /**
+    @param key The student key.
+    @returns The partition of the student.
+    */
+   std::size_t StudentPartitionHandler::partitionFor(const StudentKey & key) const {
+      return static_cast<std::size_t>(jumpHash(key.hash(), static_cast<int32_t>(replicas.size())));
+   }
+   
+   /**
+    @param partition The partition.
+    @returns The number of students routed to the partition.
+    */
+   uint64_t StudentPartitionHandler::getCount(std::size_t partition) const {
+      return partition < partitionCounts.size() ? partitionCounts[partition]->get() : 0;
+   }
+   
+   /**
+    @returns The skew of the partitions: the number of students in the largest partition
+    divided by the average number of students per partition. 1.0 is perfectly even.
+    */
+   double StudentPartitionHandler::getSkew() const {
+      uint64_t total = 0;
+      uint64_t largest = 0;
+      for (const MetricCounter * count : partitionCounts) {
+         total += count->get();
+         largest = std::max(largest, count->get());
+      }
+      if (total == 0) {
+         return 1.0;
+      }
+      return static_cast<double>(largest) * partitionCounts.size() / total;
+   }
+   
+   /**
+    Jump consistent hash (Lamping & Veach): maps a key to one of the buckets so that when
+    the number of buckets grows, only the keys moving to the new buckets change bucket.
+    @param key The hashed key.
+    @param buckets The number of buckets, at least one.
+    @returns The bucket, 0..buckets-1.
+    */
+   int32_t StudentPartitionHandler::jumpHash(uint64_t key, int32_t buckets) {
+      int64_t bucket = -1;
+      int64_t next = 0;
+      while (next < buckets) {
+         bucket = next;
+         key = key * 2862933555777941757ULL + 1;
+         next = static_cast<int64_t>((bucket + 1) * (static_cast<double>(1LL << 31) / static_cast<double>((key >> 33) + 1)));
+      }
+      return static_cast<int32_t>(bucket);
+   }
+   
+   
+} //namespace
@@ -0,0 +1,46 @@
+//
+//  StudentRecordFormatter.cpp
+//  PipesAndFiltersFramework
+//
+//  Created by Antti Juustila on 19.10.2026.
+//  Copyright (c) 2026 Antti Juustila. All rights reserved.
+//
+
+#include <charconv>
+
+#include <StudentNodeElements/StudentRecordFormatter.h>
+#include <StudentNodeElements/StudentDataItem.h>
+
+
+namespace OHARStudent {
+   
+   /** Formats one student record to the end of the buffer.
+    @param student The student to format. */
+   void StudentRecordFormatter::append(const StudentDataItem & student) {
+      buffer += student.getId();
+      buffer += '\t';
+      buffer += student.getName();
+      buffer += '\t';
+      buffer += student.getStudyProgram();
+      buffer += '\t';
+      appendNumber(student.getExamPoints());
+      buffer += '\t';
+      appendNumber(student.getExercisePointsTotal());
+      buffer += '\t';
+      appendNumber(student.getCourseProjectPoints());
+      buffer += '\t';
+      appendNumber(student.getGrade());
+      buffer += '\n';
+   }
+   
+   /** Formats a number to the end of the buffer.
+    @param value The number to format. */
+   void StudentRecordFormatter::appendNumber(int value) {
+      // Enough for any 32 bit int with the sign.
+      char digits[12];
+      std::to_chars_result result = std::to_chars(digits, digits + sizeof(digits), value);
+      buffer.append(digits, result.ptr);
+   }
+   
+   
+} //namespace
@@ -0,0 +1,179 @@
+//
+//  StudentTracer.cpp
+//  PipesAndFiltersFramework
+//
+//  Created by Antti Juustila on 19.10.2026.
+//  Copyright (c) 2026 Antti Juustila. All rights reserved.
+//
+
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <unistd.h>
+
+#include <g3log/g3log.hpp>
+
+#include <nlohmann/json.hpp>
+
+#include <StudentNodeElements/StudentTracer.h>
+#include <StudentNodeElements/StudentDataItem.h>
+
+
+namespace OHARStudent {
+   
+   std::atomic<bool> StudentTracer::enabled{false};
+   std::atomic<uint32_t> StudentTracer::sampleEvery{1};
+   std::atomic<std::size_t> StudentTracer::spansPerThread{65536};
+   
+   namespace {
+      
+      /** One recorded span. */
+      struct Span {
+         const char * name;
+         StudentKey key;
+         std::chrono::steady_clock::time_point start;
+         std::chrono::steady_clock::time_point end;
+      };
+      
+      /** The spans recorded by one thread. The lock is only contended while exporting. */
+      struct SpanRing {
+         std::vector<Span> spans;
+         std::size_t next = 0;
+         bool wrapped = false;
+         int threadNumber = 0;
+         std::mutex ringGuard;
+      };
+      
+      /** All the rings ever created, kept alive so spans of ended threads can be exported. */
+      std::mutex ringsGuard;
+      std::vector<std::shared_ptr<SpanRing>> rings;
+      const std::chrono::steady_clock::time_point traceEpoch = std::chrono::steady_clock::now();
+      
+      SpanRing & threadRing(std::size_t capacity) {
+         thread_local std::shared_ptr<SpanRing> ring;
+         if (!ring) {
+            ring = std::make_shared<SpanRing>();
+            ring->spans.resize(capacity);
+            std::lock_guard<std::mutex> guard(ringsGuard);
+            ring->threadNumber = static_cast<int>(rings.size()) + 1;
+            rings.push_back(ring);
+         }
+         return *ring;
+      }
+   }
+   
+   /**
+    Enables tracing.
+    @param every Trace one in this many students; 1 traces all students.
+    @param spansPerThread The capacity of the ring buffer of each thread created after this call.
+    */
+   void StudentTracer::enable(uint32_t every, std::size_t spansPerThread) {
+      sampleEvery.store(every > 0 ? every : 1, std::memory_order_relaxed);
+      StudentTracer::spansPerThread.store(spansPerThread > 0 ? spansPerThread : 1, std::memory_order_relaxed);
+      enabled.store(true, std::memory_order_relaxed);
+   }
+   
+   /** Disables tracing. Recorded spans are kept for exporting. */
+   void StudentTracer::disable() {
+      enabled.store(false, std::memory_order_relaxed);
+   }
+   
+   /** Checks if the student is sampled. The decision depends only on the key, so that the
+    same students are traced in all handlers.
+    @param key The key of the student.
+    @returns True if the student should be traced. */
+   bool StudentTracer::isSampled(const StudentKey & key) {
+      uint32_t every = sampleEvery.load(std::memory_order_relaxed);
+      return every <= 1 || key.hash() % every == 0;
+   }
+   
+   /** Records a span into the ring buffer of the calling thread.
+    @param name The name of the span (handler or stage), must be a string literal.
+    @param key The key of the student.
+    @param start When the span started.
+    @param end When the span ended. */
+   void StudentTracer::record(const char * name, const StudentKey & key, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end) {
+      SpanRing & ring = threadRing(spansPerThread.load(std::memory_order_relaxed));
+      std::lock_guard<std::mutex> guard(ring.ringGuard);
+      ring.spans[ring.next] = Span{name, key, start, end};
+      if (++ring.next == ring.spans.size()) {
+         ring.next = 0;
+         ring.wrapped = true;
+      }
+   }
+   
+   /**
+    Exports the recorded spans of all threads into a file in the Chrome trace event format.
+    @param fileName The file to write to.
+    @returns True if the file was written.
+    */
+   bool StudentTracer::exportChromeTrace(const std::string & fileName) {
+      using std::chrono::duration;
+      using std::chrono::duration_cast;
+      nlohmann::json events = nlohmann::json::array();
+      const int processId = static_cast<int>(::getpid());
+      std::vector<std::shared_ptr<SpanRing>> ringsToExport;
+      {
+         std::lock_guard<std::mutex> guard(ringsGuard);
+         ringsToExport = rings;
+      }
+      for (const std::shared_ptr<SpanRing> & ring : ringsToExport) {
+         std::lock_guard<std::mutex> guard(ring->ringGuard);
+         std::size_t count = ring->wrapped ? ring->spans.size() : ring->next;
+         std::size_t first = ring->wrapped ? ring->next : 0;
+         for (std::size_t index = 0; index < count; index++) {
+            const Span & span = ring->spans[(first + index) % ring->spans.size()];
+            events.push_back({
+               {"name", span.name},
+               {"cat", "student"},
+               {"ph", "X"},
+               {"ts", duration<double, std::micro>(span.start - traceEpoch).count()},
+               {"dur", duration<double, std::micro>(span.end - span.start).count()},
+               {"pid", processId},
+               {"tid", ring->threadNumber},
+               {"args", {{"id", span.key.toString()}}}
+            });
+         }
+      }
+      std::ofstream file(fileName, std::ofstream::out | std::ofstream::trunc);
+      if (!file.is_open()) {
+         LOG(WARNING) << "StudentTracer could not open " << fileName;
+         return false;
+      }
+      file << nlohmann::json{{"traceEvents", events}, {"displayTimeUnit", "ms"}}.dump() << '\n';
+      LOG(INFO) << "StudentTracer exported " << events.size() << " spans to " << fileName;
+      return true;
+   }
+   
+   void TraceSpan::begin(const char * name, const StudentDataItem * student) {
+      active = true;
+      this->name = name;
+      key = nullptr;
+      assignStudent(student);
+      start = std::chrono::steady_clock::now();
+   }
+   
+   void TraceSpan::assignStudent(const StudentDataItem * student) {
+      if (student) {
+         if (key) {
+            *key = student->getKey();
+         } else {
+            key = new (keyStorage) StudentKey(student->getKey());
+         }
+      }
+   }
+   
+   void TraceSpan::end() {
+      if (key) {
+         if (StudentTracer::isSampled(*key)) {
+            StudentTracer::record(name, *key, start, std::chrono::steady_clock::now());
+         }
+         key->~StudentKey();
+      }
+   }
+   
+   
+} //namespace
@@ -16,6 +16,9 @@
 #include <StudentNodeElements/StudentDataItem.h>
 #include <StudentNodeElements/StudentWriterHandler.h>
 #include <StudentNodeElements/StudentFileWriter.h>
+#include <StudentNodeElements/StudentColumnFile.h>
+#include <StudentNodeElements/MetricsRegistry.h>
+#include <StudentNodeElements/StudentTracer.h>
 
 
 namespace OHARStudent {
@@ -25,40 +28,88 @@ namespace OHARStudent {
     /** Initializes the writer handler by creating the writer object. The file name
      used to write the student data into, is gotten from the ProcessorNode configuration.
      @param myNode The node where the handler is.
+     @param compression Whether the file is compressed, by default chosen by the file name extension (see StudentFileWriter).
      */
-    StudentWriterHandler::StudentWriterHandler(OHARBase::ProcessorNode & myNode)
-    : node(myNode)
+    StudentWriterHandler::StudentWriterHandler(OHARBase::ProcessorNode & myNode, StudentFileWriter::Compression compression)
+    : node(myNode), columnBatches(0),
+    metricsName(MetricsRegistry::get().instanceName("StudentWriterHandler")),
+    writtenCount(MetricsRegistry::get().counter(metricsName, "written")),
+    consumeTime(MetricsRegistry::get().histogram(metricsName, "consume")),
+    allocationStage(metricsName),
+    status(myNode, "StudentWriterHandler", "")
     {
-        writer = new StudentFileWriter(node.getOutputFileName());
+        writer = new StudentFileWriter(node.getOutputFileName(), compression);
     }
     
-    /** Deletes the writer, thus closing the file. */
+    /** Deletes the writer, thus closing the file. The columnar report is written, if enabled. */
     StudentWriterHandler::~StudentWriterHandler() {
         delete writer;
     }
     
+    /**
+     Enables writing the students also into a columnar binary report file, in addition to the
+     text report. Analytics can then memory map the file with StudentColumnReader and scan single
+     columns without parsing text. The file is written at the end of the batch ("flush" control
+     package) and when the handler is destroyed. The first batch is written into the file given,
+     the following ones into files with the batch number appended (fileName.2, fileName.3, ...).
+     Call this before the handler starts receiving data.
+     @param fileName The columnar report file.
+     */
+    void StudentWriterHandler::enableColumnarOutput(const std::string & fileName) {
+        columnFileName = fileName;
+        columnBatches = 1;
+        columnWriter = std::make_unique<StudentColumnWriter>(fileName);
+    }
+    
     /**
      Consumes the data package containing the student data. Writes the student data into a file.
+     A "flush" control package (end of the batch) writes the buffered records to the disk, and
+     the columnar report file of the batch, if enabled.
      @param data The package containing the student data to write.
      @returns Returns false, since there is no need to further manipulate the data. It is
      assumed that writing the finished data into a file is the final step in student data processing
      and further processing is not needed.
      */
     bool StudentWriterHandler::consume(OHARBase::Package & data) {
+        AllocationTag allocationTag(allocationStage);
         LOG(INFO) << TAG << "Starting to write a package to a file";
         if (data.getType() == OHARBase::Package::Data) {
             OHARBase::DataItem * item = data.getPayloadObject();
             if (item) {
                 const StudentDataItem * student = dynamic_cast<const StudentDataItem*>(item);
                 if (student) {
+                    ScopedLatency timer(consumeTime);
+                    TraceSpan span("write", student);
                     writer->write(student);
-                    node.showUIMessage("Wrote data to file for student " + student->getName());
+                    if (!columnFileName.empty()) {
+                        std::lock_guard<std::mutex> guard(columnGuard);
+                        if (!columnWriter) {
+                            columnWriter = std::make_unique<StudentColumnWriter>(columnFileName + "." + std::to_string(++columnBatches));
+                        }
+                        columnWriter->write(*student);
+                    }
+                    writtenCount.add();
+                    status.written();
+                    status.publishIfDue();
                 } else {
                    LOG(WARNING) << TAG << "No student object to write to the file";
                 }
             } else {
                LOG(WARNING) << TAG << "No object in Package to write to the file";
             }
+        } else if (data.getType() == OHARBase::Package::Control && data.getPayloadString() == "flush") {
+            LOG(INFO) << TAG << "End of the batch, writing the report to the disk";
+            if (!writer->flush()) {
+                node.showUIMessage("Writer: could not write the report file");
+            }
+            std::unique_ptr<StudentColumnWriter> batchColumns;
+            {
+                std::lock_guard<std::mutex> guard(columnGuard);
+                batchColumns.swap(columnWriter);
+            }
+            if (batchColumns && !batchColumns->close()) {
+                node.showUIMessage("Writer: could not write the columnar report file");
+            }
         }
         return false; // Don't let others handle this data package since it is now finally handled.
     }
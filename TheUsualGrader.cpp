@@ -23,5 +23,9 @@ namespace OHARStudent {
       int dice_roll = distribution(generator);
       return dice_roll;
    }
+   
+   std::string TheUsualGrader::getName() const {
+      return "usual";
+   }
 
 } //namespace
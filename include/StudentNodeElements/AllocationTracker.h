@@ -0,0 +1,80 @@
+//
+//  AllocationTracker.h
+//  PipesAndFiltersFramework
+//
+//  Created by Antti Juustila on 19.10.2026.
+//  Copyright (c) 2026 Antti Juustila. All rights reserved.
+//
+
+#ifndef __PipesAndFiltersFramework__AllocationTracker__
+#define __PipesAndFiltersFramework__AllocationTracker__
+
+#include <cstddef>
+#include <string>
+
+
+namespace OHARStudent {
+   
+   class MetricCounter;
+   
+   /**
+    Counts the memory allocations made while a handler (a stage of the pipeline) is handling
+    data. The counts are the counters "allocations", "allocated_bytes" and "frees" of the
+    handler in the MetricsRegistry; allocation rates per stage are then seen by comparing
+    the timestamped metrics snapshots.
+    <p>
+    Allocations are counted only if the library is built with the SNE_ALLOCATION_ACCOUNTING
+    option, which replaces the global operator new and delete. Otherwise the stages register
+    no metrics and the AllocationTags only set a thread local pointer.
+    */
+   class AllocationStage {
+   public:
+      explicit AllocationStage(const std::string & handlerName);
+      AllocationStage(const AllocationStage &) = delete;
+      AllocationStage & operator = (const AllocationStage &) = delete;
+      
+      static bool isEnabled();
+      
+      /** Counts an allocation in the stage active in this thread, if any.
+       Called from operator new, so must not allocate. */
+      static void countAllocation(std::size_t bytes) noexcept;
+      /** Counts a deallocation in the stage active in this thread, if any. */
+      static void countFree() noexcept;
+      
+   private:
+      friend class AllocationTag;
+      
+      MetricCounter * allocations;
+      MetricCounter * allocatedBytes;
+      MetricCounter * frees;
+      
+      /** The stage whose allocations are counted in this thread, null for none. */
+      static thread_local AllocationStage * current;
+   };
+   
+   /**
+    Sets the stage allocations are counted to in this thread, for the lifetime of the tag.
+    Place one at the start of a handler's consume or handleNewItem. Tags can be nested: when
+    a handler passes data to the next handlers, those count into their own stages, and the
+    previous stage is active again when they return.
+    */
+   class AllocationTag {
+   public:
+      explicit AllocationTag(AllocationStage & stage) noexcept
+      : previous(AllocationStage::current)
+      {
+         AllocationStage::current = &stage;
+      }
+      ~AllocationTag() {
+         AllocationStage::current = previous;
+      }
+      AllocationTag(const AllocationTag &) = delete;
+      AllocationTag & operator = (const AllocationTag &) = delete;
+   private:
+      AllocationStage * previous;
+   };
+   
+   
+} //namespace
+
+#endif /* defined(__PipesAndFiltersFramework__AllocationTracker__) */
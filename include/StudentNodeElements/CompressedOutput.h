@@ -0,0 +1,88 @@
+//
+//  CompressedOutput.h
+//  PipesAndFiltersFramework
+//
+//  Created by Antti Juustila on 19.10.2026.
+//  Copyright (c) 2026 Antti Juustila. All rights reserved.
+//
+
+#ifndef __PipesAndFiltersFramework__CompressedOutput__
+#define __PipesAndFiltersFramework__CompressedOutput__
+
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+
+namespace OHARStudent {
+   
+   /**
+    Writes a compressed file as a stream. Data written is queued and compressed with zlib
+    in a background thread, so that the writing thread does not wait for the compression
+    (unless the compression falls behind so much that the queue is full).
+    A gzip file is opened for appending, so each CompressedOutput adds a new gzip member
+    after the existing content; gzip tools decompress the members one after the other.
+    A zlib file can hold only one stream, so it is replaced instead. If compressing or
+    writing fails, the error is latched: the rest of the data is dropped, and flush and
+    close report the failure. Compression is available only if the library was built
+    with zlib, see isAvailable().
+    */
+   class CompressedOutput {
+   public:
+      /** The compressed formats. */
+      enum class Format {
+         Gzip,
+         Zlib
+      };
+      
+      static bool isAvailable();
+      
+      CompressedOutput(const std::string & fileName, Format format, int level = 6);
+      ~CompressedOutput();
+      CompressedOutput(const CompressedOutput &) = delete;
+      CompressedOutput & operator = (const CompressedOutput &) = delete;
+      
+      bool isOpen() const;
+      void write(const char * data, std::size_t length);
+      bool flush();
+      bool close();
+      
+   private:
+      /** A chunk of data to compress, or a request to flush. */
+      struct Chunk {
+         std::string data;
+         bool flush = false;
+      };
+      
+      void compressChunks();
+      bool deflateChunk(const std::string & data, int mode);
+      
+      /** The zlib stream, hidden here so that users do not need the zlib headers. */
+      struct Stream;
+      std::unique_ptr<Stream> stream;
+      /** The compressed file. */
+      std::FILE * file;
+      /** Chunks waiting for the compression thread. */
+      std::deque<Chunk> queue;
+      /** The number of chunks written but not yet compressed, including the one being compressed. */
+      std::size_t unfinished;
+      bool closing;
+      /** Set when compressing or writing has failed; the file is then incomplete. */
+      bool failed;
+      std::mutex queueGuard;
+      std::condition_variable queueChanged;
+      std::thread compressor;
+      
+      /** The writer waits when this many chunks are waiting to be compressed. */
+      static const std::size_t MaxQueuedChunks = 8;
+      static const std::string TAG;
+   };
+   
+   
+} //namespace
+
+#endif /* defined(__PipesAndFiltersFramework__CompressedOutput__) */
@@ -10,13 +10,21 @@
 #define __PipesAndFiltersFramework__CruelGrader__
 
 #include <StudentNodeElements/GradeCalculator.h>
+#include <StudentNodeElements/PolicyGrader.h>
 
 namespace OHARStudent {
 
-	/** One implementation for grading students */
+   /** The rules of the cruel grader: exam points 12-17 give grade 1 and 18 or more grade 2, one
+    more for every 10 points of half the exercise points plus the project points, but never a 5. */
+   inline constexpr GradingRules<2> CruelRules{"cruel", {{ {12, 1}, {18, 2} }}, 2, 1, 10, 4};
+   /** The cruel grading policy, for grading in batches without virtual calls. */
+   typedef PolicyGrader<CruelRules> CruelPolicy;
+   
+	/** One implementation for grading students, delegating to CruelPolicy. */
    class CruelGrader : public GradeCalculator {
    public:
       int calculate(const StudentDataItem & source) override;
+      std::string getName() const override;
    };
       
 	
@@ -0,0 +1,52 @@
+//
+//  DelimiterScanner.h
+//  PipesAndFiltersFramework
+//
+//  Created by Antti Juustila on 19.10.2026.
+//  Copyright (c) 2026 Antti Juustila. All rights reserved.
+//
+
+#ifndef __PipesAndFiltersFramework__DelimiterScanner__
+#define __PipesAndFiltersFramework__DelimiterScanner__
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace OHARStudent {
+   
+   /**
+    Finds the field (tab) and record (newline) delimiters of a tsv buffer in one pass.
+    On x86 the buffer is scanned 32 (AVX2) or 16 (SSE2) bytes at a time, comparing the bytes to
+    the delimiters with vector instructions and walking the bits of the resulting masks. The
+    implementation is selected at runtime by the features of the CPU; other CPUs use a scalar
+    loop. All implementations produce the same index.
+    */
+   class DelimiterScanner {
+   public:
+      enum class Implementation { Scalar, SSE2, AVX2 };
+      
+      /** The delimiters found in a buffer. */
+      struct Index {
+         /** Offsets of all the delimiters (tabs and newlines), in order. */
+         std::vector<uint32_t> delimiters;
+         /** For each record, the position in delimiters of the newline ending the record. */
+         std::vector<uint32_t> recordEnds;
+         void clear() {
+            delimiters.clear();
+            recordEnds.clear();
+         }
+      };
+      
+      static void scan(const char * data, std::size_t length, Index & index);
+      static void scan(Implementation implementation, const char * data, std::size_t length, Index & index);
+      
+      static Implementation getBestImplementation();
+      static bool isSupported(Implementation implementation);
+      static const char * getName(Implementation implementation);
+   };
+   
+   
+} //namespace
+
+#endif /* defined(__PipesAndFiltersFramework__DelimiterScanner__) */
@@ -0,0 +1,103 @@
+//
+//  FlowControl.h
+//  PipesAndFiltersFramework
+//
+//  Created by Antti Juustila on 19.10.2026.
+//  Copyright (c) 2026 Antti Juustila. All rights reserved.
+//
+
+#ifndef __PipesAndFiltersFramework__FlowControl__
+#define __PipesAndFiltersFramework__FlowControl__
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <string>
+
+
+namespace OHARStudent {
+   
+   class FlowControl;
+   class MetricGauge;
+   
+   /**
+    A credit for one item in flight, gotten from FlowControl::acquire. The credit is
+    returned to the FlowControl when the credit object is destroyed.
+    <p>
+    While an item is being handled, the credit is the current credit of the handling thread
+    (see Scope). A handler which passes the item to another thread (e.g. a queue of a worker
+    pool) can take the credit with takeCurrent and keep it with the item, so that the item is
+    in flight until the other thread has handled it.
+    */
+   class FlowCredit {
+   public:
+      FlowCredit();
+      FlowCredit(FlowCredit && another);
+      FlowCredit & operator = (FlowCredit && another);
+      ~FlowCredit();
+      
+      void release();
+      bool isValid() const;
+      
+      static FlowCredit takeCurrent();
+      
+      /** Makes the credit the current credit of the thread for the lifetime of the scope. */
+      class Scope {
+      public:
+         explicit Scope(FlowCredit & credit);
+         ~Scope();
+      private:
+         FlowCredit * previous;
+      };
+      
+   private:
+      friend class FlowControl;
+      explicit FlowCredit(FlowControl * owner);
+      FlowCredit(const FlowCredit &) = delete;
+      FlowCredit & operator = (const FlowCredit &) = delete;
+      
+      FlowControl * owner;
+      static thread_local FlowCredit * current;
+   };
+   
+   /**
+    Bounded credit flow control between a producer (the file reading thread) and the
+    handlers after it. The producer acquires a credit for each item before passing it on,
+    and blocks when the configured number of items are in flight. Credits are returned when
+    the item has been handled, so a producer cannot run arbitrarily far ahead of slow
+    handlers and fill the memory with queued items.
+    <p>
+    The number of items in flight and its high watermark are reported as the "in_flight"
+    gauge of the given handler in the MetricsRegistry.
+    <p>
+    A producer waiting for a credit stops waiting when its cancel flag is set; whoever sets
+    the flag calls wakeWaiters, so the producer notices it without waiting for a credit.
+    */
+   class FlowControl {
+   public:
+      FlowControl(const std::string & handlerName, std::size_t maxInFlight = 0);
+      ~FlowControl();
+      
+      void setMaxInFlight(std::size_t maxInFlight);
+      FlowCredit acquire(const std::atomic<bool> * cancelFlag = nullptr);
+      void wakeWaiters();
+      std::size_t getInFlight() const;
+      std::size_t getHighWatermark() const;
+      
+   private:
+      friend class FlowCredit;
+      void release();
+      
+      /** Maximum items in flight, zero if not limited. */
+      std::size_t maxInFlight;
+      std::size_t inFlight;
+      mutable std::mutex flowGuard;
+      std::condition_variable creditReturned;
+      MetricGauge & inFlightGauge;
+   };
+   
+   
+} //namespace
+
+#endif /* defined(__PipesAndFiltersFramework__FlowControl__) */
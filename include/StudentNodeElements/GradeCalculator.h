@@ -9,6 +9,10 @@
 #ifndef PipesAndFiltersFramework_GradeCalculator_h
 #define PipesAndFiltersFramework_GradeCalculator_h
 
+#include <cstdint>
+#include <memory>
+#include <string>
+
 namespace OHARStudent {
 
 	
@@ -25,8 +29,24 @@ namespace OHARStudent {
        @returns The grade for the student. 
        */
       virtual int calculate(const StudentDataItem & source) = 0;
+      /** The name of the grading method, used to tell apart grades given by different methods.
+       @returns The name of the grader. */
+      virtual std::string getName() const { return "grader"; }
       virtual ~GradeCalculator() {};
    };
+   
+   /**
+    A grade calculator published for grading students (see StudentDataItem::setGradeCalculator).
+    Each published calculator gets a new version number, recorded in the students it grades.
+    Graders hold a reference to the policy while grading, so replacing the policy never deletes
+    a calculator in use.
+    */
+   struct GradingPolicy {
+      std::shared_ptr<GradeCalculator> calculator;
+      /** The name of the calculator, see GradeCalculator::getName. */
+      std::string name;
+      uint32_t version;
+   };
       
 	
 } //namespace
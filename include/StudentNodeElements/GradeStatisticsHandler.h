@@ -0,0 +1,106 @@
+//
+//  GradeStatisticsHandler.h
+//  PipesAndFiltersFramework
+//
+//  Created by Antti Juustila on 19.10.2026.
+//  Copyright (c) 2026 Antti Juustila. All rights reserved.
+//
+
+#ifndef __PipesAndFiltersFramework__GradeStatisticsHandler__
+#define __PipesAndFiltersFramework__GradeStatisticsHandler__
+
+#include <array>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include <ProcessorNode/DataHandler.h>
+
+#include <StudentNodeElements/AllocationTracker.h>
+
+namespace OHARBase {
+   class Package;
+}
+
+namespace OHARStudent {
+   
+   class StudentDataItem;
+   
+   /**
+    Collects grade statistics of the graded students, per study program and for the whole
+    course, as the students pass by: the number of students with each grade, the pass rate,
+    and the count, mean, variance and quantiles of the exam, exercise and course project points.
+    Place the handler after the GradingHandler. The students are passed on unchanged.
+    <p>
+    Each thread updates its own accumulator, so the threads passing students (e.g. grading
+    workers) do not contend with each other; the accumulators are merged when a snapshot is
+    taken. The snapshot is written into the statistics file at the end of the batch: when a
+    "flush" control package arrives, and when the handler is destroyed.
+    */
+   class GradeStatisticsHandler : public OHARBase::DataHandler {
+   public:
+      GradeStatisticsHandler(const std::string & fileName);
+      virtual ~GradeStatisticsHandler();
+      
+      bool consume(OHARBase::Package & data) override;
+      
+      nlohmann::json snapshot() const;
+      bool writeSnapshot() const;
+      
+   private:
+      /** Count, mean and variance of points (Welford), with the exact distribution for quantiles. */
+      struct PointStatistics {
+         uint64_t count = 0;
+         double mean = 0.0;
+         double m2 = 0.0;
+         std::map<int, uint64_t> histogram;
+         void add(int points);
+         void merge(const PointStatistics & other);
+         nlohmann::json toJson() const;
+      };
+      
+      /** The statistics of a group of students: a study program or the whole course. */
+      struct GroupStatistics {
+         uint64_t students = 0;
+         /** Students by grade 0..5; other values (e.g. not graded) are counted as ungraded. */
+         std::array<uint64_t, 6> grades{};
+         uint64_t ungraded = 0;
+         PointStatistics exam;
+         PointStatistics exercise;
+         PointStatistics project;
+         void add(const StudentDataItem & student);
+         void merge(const GroupStatistics & other);
+         nlohmann::json toJson() const;
+      };
+      
+      /** The statistics collected by one thread, per study program. */
+      struct Accumulator {
+         std::mutex guard;
+         std::map<std::string, GroupStatistics> programs;
+      };
+      
+      Accumulator & threadAccumulator();
+      
+      /** The file the snapshot is written into. */
+      std::string fileName;
+      /** Identifies this handler in the threads' accumulator maps. */
+      const uint64_t handlerId;
+      /** The accumulators of all threads which have passed students to this handler. */
+      std::vector<std::shared_ptr<Accumulator>> accumulators;
+      mutable std::mutex accumulatorsGuard;
+      /** The name the metrics of this handler are registered with (see MetricsRegistry::instanceName). */
+      const std::string metricsName;
+      /** Counts the allocations made while handling data, if allocation accounting is enabled. */
+      AllocationStage allocationStage;
+      static const std::string TAG;
+   };
+   
+   
+} //namespace
+
+#endif /* defined(__PipesAndFiltersFramework__GradeStatisticsHandler__) */
@@ -0,0 +1,77 @@
+//
+//  GradeStore.h
+//  PipesAndFiltersFramework
+//
+//  Created by Antti Juustila on 19.10.2026.
+//  Copyright (c) 2026 Antti Juustila. All rights reserved.
+//
+
+#ifndef __PipesAndFiltersFramework__GradeStore__
+#define __PipesAndFiltersFramework__GradeStore__
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+#include <StudentNodeElements/StudentKey.h>
+
+
+namespace OHARStudent {
+   
+   class StudentDataItem;
+   
+   /**
+    A persistent store of the grades given in previous runs. For each student, the store
+    keeps a hash of the data the grade was calculated from, and the grade. When the same
+    student arrives with unchanged data in a later run, the grade can be taken from the
+    store instead of grading the student again.
+    <p>
+    The store is a tab separated file with the student id, the input hash (hex) and the grade
+    on each line. It is read when the store is created, and written back periodically in a
+    background thread, when saved and when destroyed. The file is replaced atomically, so a node
+    crashing in the middle of a run loses at most the grades of the last save interval.
+    */
+   class GradeStore {
+   public:
+      GradeStore(const std::string & fileName, std::chrono::milliseconds saveInterval = std::chrono::seconds(10));
+      ~GradeStore();
+      
+      bool findGrade(const StudentDataItem & student, uint64_t inputHash, int & grade) const;
+      void storeGrade(const StudentDataItem & student, uint64_t inputHash, int grade);
+      void save();
+      
+      static uint64_t inputHash(const StudentDataItem & student, const std::string & graderName);
+      
+   private:
+      /** The hash of the inputs and the grade given for one student. */
+      struct Entry {
+         uint64_t inputHash;
+         int grade;
+      };
+      
+      void run();
+      
+      std::string fileName;
+      std::unordered_map<StudentKey, Entry> entries;
+      /** Grading may happen in several threads at the same time. */
+      mutable std::mutex storeGuard;
+      bool changed;
+      /** Serializes the writing of the file between the saver thread and save calls. */
+      std::mutex saveGuard;
+      /** How often the changed grades are saved. */
+      std::chrono::milliseconds saveInterval;
+      bool running;
+      std::condition_variable wakeUp;
+      std::thread saverThread;
+      
+      static const std::string TAG;
+   };
+   
+   
+} //namespace
+
+#endif /* defined(__PipesAndFiltersFramework__GradeStore__) */
@@ -9,8 +9,16 @@
 #ifndef __PipesAndFiltersFramework__GradingHandler__
 #define __PipesAndFiltersFramework__GradingHandler__
 
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+
 #include <ProcessorNode/DataHandler.h>
 
+#include <StudentNodeElements/AllocationTracker.h>
+
 namespace OHARBase {
 	class ProcessorNode;
 	class Package;
@@ -19,8 +27,19 @@ namespace OHARBase {
 
 namespace OHARStudent {
 	
+   class GradeCalculator;
+   class GradeStore;
+   struct GradingPolicy;
+   class PackageWorkerPool;
+   class StudentDataItem;
+   class MetricCounter;
+   class MetricHistogram;
+   
 	/** A handler for determining the final grade for the student,
     based on how the student managed the various areas of the course.
+    <p>
+    The grader can be replaced with setGrader while students are being graded. Each student
+    is graded with the grader published when its grading started, and records its version.
     */
 	class GradingHandler : public OHARBase::DataHandler {
 	public:
@@ -29,7 +48,32 @@ namespace OHARStudent {
 		
 		bool consume(OHARBase::Package & data) override;
 		
+      void enableGradeStore(const std::string & fileName, std::chrono::milliseconds saveInterval = std::chrono::seconds(10));
+      void enableWorkerPool(OHARBase::ProcessorNode & node, std::size_t workerCount = 0, bool preserveOrder = true);
+      uint32_t setGrader(std::shared_ptr<GradeCalculator> grader);
+      
 	private:
+      void grade(StudentDataItem & student);
+      bool applyStoredGrade(StudentDataItem & student, const GradingPolicy & policy, uint64_t & inputHash);
+      
+      /** The version of the grading policy this handler published last. */
+      std::atomic<uint32_t> policyVersion;
+      /** If enabled, the grades from previous runs, used to skip grading of unchanged students. */
+      std::unique_ptr<GradeStore> gradeStore;
+      /** True if the worker pool passes the students on in the order they arrived. */
+      bool poolPreservesOrder;
+      
+      /** The name the metrics of this handler are registered with (see MetricsRegistry::instanceName). */
+      const std::string metricsName;
+      /** Metrics: students received, graded, grades reused from the store and time spent grading. */
+      MetricCounter & consumedCount;
+      MetricCounter & gradedCount;
+      MetricCounter & unchangedCount;
+      MetricHistogram & consumeTime;
+      /** Counts the allocations made while handling data, if allocation accounting is enabled. */
+      AllocationStage allocationStage;
+      /** If enabled, grades the students in worker threads instead of the calling thread. */
+      std::unique_ptr<PackageWorkerPool> workerPool;
       
 		static const std::string TAG;
 	};
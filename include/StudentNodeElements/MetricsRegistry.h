@@ -0,0 +1,137 @@
+//
+//  MetricsRegistry.h
+//  PipesAndFiltersFramework
+//
+//  Created by Antti Juustila on 19.10.2026.
+//  Copyright (c) 2026 Antti Juustila. All rights reserved.
+//
+
+#ifndef __PipesAndFiltersFramework__MetricsRegistry__
+#define __PipesAndFiltersFramework__MetricsRegistry__
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include <nlohmann/json.hpp>
+
+
+namespace OHARStudent {
+   
+   /** A metric counting events, like items consumed by a handler. */
+   class MetricCounter {
+   public:
+      MetricCounter() : value(0) {}
+      void add(uint64_t amount = 1) { value.fetch_add(amount, std::memory_order_relaxed); }
+      uint64_t get() const { return value.load(std::memory_order_relaxed); }
+   private:
+      std::atomic<uint64_t> value;
+   };
+   
+   /** A metric holding a current value, like the number of students held by a handler.
+    The highest value ever set is also recorded. */
+   class MetricGauge {
+   public:
+      MetricGauge() : value(0), highWatermark(0) {}
+      void set(int64_t newValue);
+      void add(int64_t amount);
+      int64_t get() const { return value.load(std::memory_order_relaxed); }
+      int64_t getHighWatermark() const { return highWatermark.load(std::memory_order_relaxed); }
+   private:
+      void updateHighWatermark(int64_t newValue);
+      std::atomic<int64_t> value;
+      std::atomic<int64_t> highWatermark;
+   };
+   
+   /** A metric recording a distribution of durations, like the time spent in consume.
+    Values are counted in buckets by powers of two (nanoseconds), so percentiles reported
+    are upper bounds of the bucket the percentile falls in. */
+   class MetricHistogram {
+   public:
+      MetricHistogram();
+      void record(std::chrono::nanoseconds duration);
+      uint64_t getCount() const { return count.load(std::memory_order_relaxed); }
+      uint64_t percentile(double fraction) const;
+      nlohmann::json toJson() const;
+   private:
+      static const int BucketCount = 64;
+      std::array<std::atomic<uint64_t>, BucketCount> buckets;
+      std::atomic<uint64_t> count;
+      std::atomic<uint64_t> sum;
+      std::atomic<uint64_t> max;
+   };
+   
+   /** Records the time from creation to destruction into a histogram. */
+   class ScopedLatency {
+   public:
+      explicit ScopedLatency(MetricHistogram & histogram)
+      : histogram(histogram), start(std::chrono::steady_clock::now()) {}
+      ~ScopedLatency() { histogram.record(std::chrono::steady_clock::now() - start); }
+   private:
+      MetricHistogram & histogram;
+      std::chrono::steady_clock::time_point start;
+   };
+   
+   /**
+    A registry of the metrics of the handlers in the node. Each handler gets its metrics
+    by handler and metric name when it is created, and keeps a reference to them. A handler
+    first gets a name for its own instance with instanceName, so that two handlers of the
+    same class (e.g. in partition replicas) do not share their metrics. Creating a
+    metric takes a lock, but updating it is a lock free atomic operation, so metrics can be
+    updated in the handlers' hot paths from any thread.
+    <p>
+    The current values can be read with snapshot(), and dumped periodically into a JSON
+    file with startDumping().
+    */
+   class MetricsRegistry {
+   public:
+      static MetricsRegistry & get();
+      ~MetricsRegistry();
+      
+      std::string instanceName(const std::string & handler);
+      MetricCounter & counter(const std::string & handler, const std::string & name);
+      MetricGauge & gauge(const std::string & handler, const std::string & name);
+      MetricHistogram & histogram(const std::string & handler, const std::string & name);
+      
+      nlohmann::json snapshot() const;
+      bool dump(const std::string & fileName) const;
+      void startDumping(const std::string & fileName, std::chrono::milliseconds interval);
+      void stopDumping();
+      
+   private:
+      MetricsRegistry();
+      MetricsRegistry(const MetricsRegistry &) = delete;
+      MetricsRegistry & operator = (const MetricsRegistry &) = delete;
+      
+      /** The metrics of one handler. */
+      struct HandlerMetrics {
+         std::map<std::string, std::unique_ptr<MetricCounter>> counters;
+         std::map<std::string, std::unique_ptr<MetricGauge>> gauges;
+         std::map<std::string, std::unique_ptr<MetricHistogram>> histograms;
+      };
+      
+      std::map<std::string, HandlerMetrics> handlers;
+      /** The number of instances named for each handler class. */
+      std::map<std::string, unsigned> instanceCounts;
+      /** Guards adding metrics and reading the metric maps, not the metric values. */
+      mutable std::mutex registryGuard;
+      
+      std::thread dumpThread;
+      std::mutex dumpGuard;
+      std::condition_variable dumpWakeUp;
+      bool dumping;
+      
+      static const std::string TAG;
+   };
+   
+   
+} //namespace
+
+#endif /* defined(__PipesAndFiltersFramework__MetricsRegistry__) */
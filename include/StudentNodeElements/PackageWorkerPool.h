@@ -0,0 +1,101 @@
+//
+//  PackageWorkerPool.h
+//  PipesAndFiltersFramework
+//
+//  Created by Antti Juustila on 19.10.2026.
+//  Copyright (c) 2026 Antti Juustila. All rights reserved.
+//
+
+#ifndef __PipesAndFiltersFramework__PackageWorkerPool__
+#define __PipesAndFiltersFramework__PackageWorkerPool__
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <ProcessorNode/Package.h>
+
+#include <StudentNodeElements/FlowControl.h>
+
+
+namespace OHARStudent {
+   
+   /**
+    A fixed pool of worker threads handling packages off the thread which delivered them.
+    Each worker has its own queue; submitted packages are distributed to the queues round robin,
+    and a worker with an empty queue steals work from the other queues.
+    <p>
+    When a package has been handled, it is emitted (usually passed to the following handlers).
+    If the order is preserved, packages are emitted in the order they were submitted; a package
+    handled early waits until the packages submitted before it have been emitted. If the order is
+    relaxed, a package is emitted as soon as it has been handled.
+    */
+   class PackageWorkerPool {
+   public:
+      /** Handles the package in a worker thread. Returns false if the package should not be emitted. */
+      typedef std::function<bool(OHARBase::Package & package)> Work;
+      /** Emits a handled package. */
+      typedef std::function<void(OHARBase::Package & package)> Emit;
+      
+      PackageWorkerPool(std::size_t workerCount, bool preserveOrder, Work work, Emit emit);
+      ~PackageWorkerPool();
+      
+      void submit(OHARBase::Package && package, FlowCredit credit);
+      void drain();
+      std::size_t getWorkerCount() const;
+      
+   private:
+      PackageWorkerPool(const PackageWorkerPool &) = delete;
+      PackageWorkerPool & operator = (const PackageWorkerPool &) = delete;
+      
+      /** A submitted package, with the flow control credit it holds until emitted. */
+      struct Job {
+         uint64_t sequence;
+         bool emit;
+         OHARBase::Package package;
+         FlowCredit credit;
+      };
+      
+      /** The queue of one worker. The owner takes jobs from the front, thieves from the back. */
+      struct WorkerQueue {
+         std::mutex queueGuard;
+         std::deque<Job> jobs;
+      };
+      
+      void run(std::size_t workerIndex);
+      bool takeJob(std::size_t workerIndex, Job & job);
+      void finish(Job && job);
+      
+      Work work;
+      Emit emit;
+      bool preserveOrder;
+      std::vector<std::unique_ptr<WorkerQueue>> queues;
+      std::vector<std::thread> threads;
+      std::atomic<uint64_t> nextSequence;
+      std::atomic<std::size_t> nextQueue;
+      
+      /** Guards the counters used for sleeping and waking up the workers. */
+      std::mutex stateGuard;
+      std::condition_variable workAvailable;
+      std::condition_variable allDone;
+      std::size_t queued;
+      std::size_t unfinished;
+      bool stopping;
+      
+      /** Guards the emitting of packages in order. */
+      std::mutex orderGuard;
+      uint64_t nextToEmit;
+      std::map<uint64_t, Job> waitingToEmit;
+   };
+   
+   
+} //namespace
+
+#endif /* defined(__PipesAndFiltersFramework__PackageWorkerPool__) */
@@ -9,10 +9,18 @@
 #ifndef __PipesAndFiltersFramework__PlainStudentFileHandler__
 #define __PipesAndFiltersFramework__PlainStudentFileHandler__
 
+#include <atomic>
+#include <chrono>
+#include <mutex>
+
 #include <ProcessorNode/DataHandler.h>
 #include <ProcessorNode/DataReaderObserver.h>
 #include <ProcessorNode/DataItem.h>
 
+#include <StudentNodeElements/FlowControl.h>
+#include <StudentNodeElements/ReaderExecutor.h>
+#include <StudentNodeElements/AllocationTracker.h>
+
 
 namespace OHARBase {
 	class ProcessorNode;
@@ -34,11 +42,37 @@ namespace OHARStudent {
       // From DataReaderObserver
       void handleNewItem(std::unique_ptr<OHARBase::DataItem> item) override;
       
+      void setMaxParallelFiles(std::size_t maxFiles);
+      void setFollowMode(bool follow);
+      void setLazyParsing(bool lazy);
+      bool waitForFileRead(std::chrono::milliseconds timeout);
+      void cancelFileRead();
+      void setMaxItemsInFlight(std::size_t maxItems);
+      
    private:
       void readFile();
+      void passEndOfBatch();
       
       OHARBase::ProcessorNode & node;
+      /** The name the metrics of this handler are registered with (see MetricsRegistry::instanceName). */
+      const std::string metricsName;
+      /** Limits how far the file reading thread can run ahead of the following handlers. */
+      FlowControl readerFlow;
+      /** How many data files are read at the same time. */
+      std::atomic<std::size_t> maxParallelFiles;
+      /** If true, data files are followed for appended rows instead of read once. */
+      std::atomic<bool> followFiles;
+      /** If true, only the ids are parsed when reading; other values when first needed. */
+      std::atomic<bool> lazyParsing;
+      /** True while the files of a batch are read, and whether the previous node ended its batch meanwhile. */
+      std::mutex batchGuard;
+      bool readingBatch;
+      bool previousNodeEnded;
+      /** Counts the allocations made while handling data, if allocation accounting is enabled. */
+      AllocationStage allocationStage;
       static const std::string TAG;
+      /** Reads the data file. Declared last, so that reading stops before the other members are destroyed. */
+      ReaderExecutor reader;
    };
 
 	
@@ -0,0 +1,124 @@
+//
+//  PolicyGrader.h
+//  PipesAndFiltersFramework
+//
+//  Created by Antti Juustila on 19.10.2026.
+//  Copyright (c) 2026 Antti Juustila. All rights reserved.
+//
+
+#ifndef __PipesAndFiltersFramework__PolicyGrader__
+#define __PipesAndFiltersFramework__PolicyGrader__
+
+#include <array>
+#include <cstddef>
+#include <string>
+
+#include <StudentNodeElements/GradeCalculator.h>
+#include <StudentNodeElements/StudentDataItem.h>
+
+namespace OHARStudent {
+   
+   /** A grade given for the exam points from minExamPoints up, until the next band. */
+   struct ExamBand {
+      int minExamPoints;
+      int grade;
+   };
+   
+   /**
+    A grading policy as a table of rules, evaluated at compile time by PolicyGrader:
+    <ul>
+    <li>The exam points select the base grade from the bands; below the first band the student fails (grade 0),
+    and no other points are then counted.</li>
+    <li>The exercise points total divided by exerciseDivisor, plus the course project points multiplied by
+    projectMultiplier, give bonus points; each pointsPerBonusGrade bonus points raise the grade by one.</li>
+    <li>The grade is capped at maxGrade.</li>
+    </ul>
+    The divisions are integer divisions.
+    */
+   template <std::size_t BandCount>
+   struct GradingRules {
+      /** The name of the policy, see GradeCalculator::getName. */
+      const char * name;
+      /** The exam bands, in ascending order of the minimum points. */
+      std::array<ExamBand, BandCount> examBands;
+      int exerciseDivisor;
+      int projectMultiplier;
+      int pointsPerBonusGrade;
+      int maxGrade;
+      
+      /** @returns True if the rules can be evaluated: bands ascending and no division by zero. */
+      constexpr bool isValid() const {
+         for (std::size_t band = 1; band < BandCount; band++) {
+            if (examBands[band].minExamPoints <= examBands[band - 1].minExamPoints) {
+               return false;
+            }
+         }
+         return BandCount > 0 && exerciseDivisor > 0 && pointsPerBonusGrade > 0 && maxGrade >= 0;
+      }
+   };
+   
+   /**
+    A grader compiled from a rule table (see GradingRules). The grading function is a constexpr
+    function of the points, so the rules are inlined into it. In batch mode, grade or gradeAll
+    are called directly, without virtual calls; the grader can also be used through GradeCalculator
+    like the other graders.
+    <p>
+    A new policy is a table, not a class:
+    <pre>
+    inline constexpr GradingRules<2> MyRules{"mine", {{ {10, 1}, {20, 3} }}, 2, 1, 10, 5};
+    typedef PolicyGrader<MyRules> MyGrader;
+    </pre>
+    */
+   template <const auto & Rules>
+   class PolicyGrader : public GradeCalculator {
+      static_assert(Rules.isValid(), "Invalid grading rules: bands must be ascending and divisors positive.");
+   public:
+      /** Calculates the grade from the points. */
+      static constexpr int grade(int examPoints, int exercisePoints, int projectPoints) {
+         int result = -1;
+         for (const ExamBand & band : Rules.examBands) {
+            if (examPoints >= band.minExamPoints) {
+               result = band.grade;
+            }
+         }
+         if (result < 0) {
+            return 0; // Failed the exam.
+         }
+         result += (exercisePoints / Rules.exerciseDivisor + projectPoints * Rules.projectMultiplier) / Rules.pointsPerBonusGrade;
+         return result > Rules.maxGrade ? Rules.maxGrade : result;
+      }
+      
+      /** Calculates the grade of a student. */
+      static int grade(const StudentDataItem & student) {
+         return grade(student.getExamPoints(), student.getExercisePointsTotal(), student.getCourseProjectPoints());
+      }
+      
+      /** Grades a batch of students, given as a range of StudentDataItem objects or pointers to them.
+       The students also get the policy version; zero (not known) if the grader is used without publishing it. */
+      template <typename Iterator>
+      static void gradeAll(Iterator first, Iterator last, uint32_t policyVersion = 0) {
+         for (; first != last; ++first) {
+            StudentDataItem & student = itemOf(*first);
+            student.setGrade(grade(student));
+            student.setGradePolicyVersion(policyVersion);
+         }
+      }
+      
+      int calculate(const StudentDataItem & source) override {
+         return grade(source);
+      }
+      
+      std::string getName() const override {
+         return Rules.name;
+      }
+      
+   private:
+      static StudentDataItem & itemOf(StudentDataItem & student) { return student; }
+      template <typename Pointer>
+      static StudentDataItem & itemOf(Pointer & student) { return *student; }
+   };
+   
+   
+} //namespace
+
+#endif /* defined(__PipesAndFiltersFramework__PolicyGrader__) */
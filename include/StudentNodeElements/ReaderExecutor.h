@@ -0,0 +1,83 @@
+//
+//  ReaderExecutor.h
+//  PipesAndFiltersFramework
+//
+//  Created by Antti Juustila on 19.10.2026.
+//  Copyright (c) 2026 Antti Juustila. All rights reserved.
+//
+
+#ifndef __PipesAndFiltersFramework__ReaderExecutor__
+#define __PipesAndFiltersFramework__ReaderExecutor__
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+
+namespace OHARStudent {
+   
+   /**
+    Executes file reading tasks of a handler in a thread owned by the handler. Only one
+    read can be pending or running at a time; a new read requested while one is already
+    pending or running is ignored, so a node receiving the "readfile" command twice reads
+    the file only once.
+    <p>
+    A submitted task does not start until the handler tells it is ready with markReady
+    (usually when it has finished handling the command which requested the read). The task
+    gets a cancellation flag it should check while reading. When the executor is destroyed,
+    a running task is cancelled and waited for, so the task never outlives the handler.
+    */
+   class ReaderExecutor {
+   public:
+      /** A read task. The parameter is set to true when the task should stop. */
+      typedef std::function<void(const std::atomic<bool> & cancelled)> Task;
+      /** Called when the task is cancelled, e.g. to wake up the task if it is waiting. */
+      typedef std::function<void()> CancelListener;
+      
+      ReaderExecutor(const std::string & name);
+      ~ReaderExecutor();
+      
+      bool submit(Task task);
+      void markReady();
+      void cancel();
+      void setCancelListener(CancelListener listener);
+      const std::atomic<bool> & getCancelFlag() const;
+      bool isBusy() const;
+      bool waitForCompletion(std::chrono::milliseconds timeout);
+      
+      /** Marks the executor ready when leaving the scope, whatever way the scope is left. */
+      class ReadyGate {
+      public:
+         explicit ReadyGate(ReaderExecutor & executor) : executor(executor) {}
+         ~ReadyGate() { executor.markReady(); }
+      private:
+         ReaderExecutor & executor;
+      };
+      
+   private:
+      ReaderExecutor(const ReaderExecutor &) = delete;
+      ReaderExecutor & operator = (const ReaderExecutor &) = delete;
+      
+      void run();
+      
+      std::string name;
+      Task pendingTask;
+      /** True from submitting a task until the task has finished. */
+      bool busy;
+      bool ready;
+      bool stopping;
+      std::atomic<bool> cancelled;
+      CancelListener cancelListener;
+      mutable std::mutex executorGuard;
+      std::condition_variable stateChanged;
+      std::thread worker;
+   };
+   
+   
+} //namespace
+
+#endif /* defined(__PipesAndFiltersFramework__ReaderExecutor__) */
@@ -0,0 +1,61 @@
+//
+//  StatusReporter.h
+//  PipesAndFiltersFramework
+//
+//  Created by Antti Juustila on 19.10.2026.
+//  Copyright (c) 2026 Antti Juustila. All rights reserved.
+//
+
+#ifndef __PipesAndFiltersFramework__StatusReporter__
+#define __PipesAndFiltersFramework__StatusReporter__
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+namespace OHARBase {
+   class ProcessorNode;
+}
+
+namespace OHARStudent {
+   
+   /**
+    Reports the progress of a handler to the node's UI, at a limited rate. Instead of
+    showing a UI message for every student, the handler updates counters (cheap atomic
+    operations, fine to do while holding a lock) and calls publishIfDue after releasing its
+    locks. At most the configured number of updates per second are then published, each one
+    summarizing the counts so far: one UI message and one queue count update.
+    */
+   class StatusReporter {
+   public:
+      StatusReporter(OHARBase::ProcessorNode & node, const std::string & handlerName, const std::string & queueName, unsigned maxUpdatesPerSecond = 10);
+      
+      void received();
+      void merged();
+      void written();
+      void setHeld(std::size_t count);
+      void setMaxUpdatesPerSecond(unsigned maxUpdatesPerSecond);
+      
+      void publishIfDue();
+      void publish();
+      
+   private:
+      OHARBase::ProcessorNode & node;
+      std::string handlerName;
+      std::string queueName;
+      /** Minimum time between two published updates, in steady clock ticks. */
+      std::atomic<std::chrono::steady_clock::rep> minInterval;
+      std::atomic<std::chrono::steady_clock::rep> lastPublished;
+      std::atomic<uint64_t> receivedCount;
+      std::atomic<uint64_t> mergedCount;
+      std::atomic<uint64_t> writtenCount;
+      std::atomic<std::size_t> heldCount;
+      /** True if counts have changed since the last published update. */
+      std::atomic<bool> changed;
+   };
+   
+   
+} //namespace
+
+#endif /* defined(__PipesAndFiltersFramework__StatusReporter__) */
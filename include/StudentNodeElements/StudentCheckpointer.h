@@ -0,0 +1,107 @@
+//
+//  StudentCheckpointer.h
+//  PipesAndFiltersFramework
+//
+//  Created by Antti Juustila on 19.10.2026.
+//  Copyright (c) 2026 Antti Juustila. All rights reserved.
+//
+
+#ifndef __PipesAndFiltersFramework__StudentCheckpointer__
+#define __PipesAndFiltersFramework__StudentCheckpointer__
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <StudentNodeElements/StudentKey.h>
+
+
+namespace OHARStudent {
+   
+   class StudentDataItem;
+   
+   /**
+    Writes incremental checkpoints of the students held by a StudentHandler into a
+    local snapshot file, so that a restarted node can restore the join state instead
+    of the whole pipeline re-reading and re-sending the data.
+    <p>
+    The handler reports each change (a student held or released) while holding its own lock.
+    Those calls only copy the student into a pending batch; encoding and file access happen
+    in the background. A background thread
+    periodically appends the pending batch to the snapshot file. When the file has grown
+    much larger than the state it describes, the file is compacted by rewriting only the
+    students currently held.
+    <p>
+    The snapshot file is a sequence of records: a one byte record type, a four byte
+    little endian payload length and the payload. Added students are stored as one byte
+    for the source of the student (StudentSource) followed by CBOR encoded JSON (the same
+    structure used in the network), removed students as the plain id. Files of the first
+    version, without the source byte, are still restored; their students get the Unknown source.
+    */
+   class StudentCheckpointer {
+   public:
+      StudentCheckpointer(const std::string & fileName, std::chrono::milliseconds interval);
+      ~StudentCheckpointer();
+      
+      /** A restored student and where it came from. */
+      typedef std::pair<std::unique_ptr<StudentDataItem>, StudentSource> Restored;
+      
+      std::vector<Restored> restore();
+      void start();
+      void stop();
+      
+      void studentHeld(const StudentDataItem & student, StudentSource source);
+      void studentReleased(const StudentKey & key);
+      
+   private:
+      /** One change in the join state, waiting to be written to the file. */
+      struct Change {
+         char type;
+         StudentKey key;
+         StudentSource source;
+         /** Copy of the held student, null when the student was released. */
+         std::unique_ptr<StudentDataItem> student;
+      };
+      
+      void run();
+      void writePending();
+      void appendRecord(std::ofstream & out, char type, const uint8_t * data, uint32_t length);
+      void compact();
+      
+      /** The snapshot file name. */
+      std::string fileName;
+      /** How often pending changes are written to the file. */
+      std::chrono::milliseconds interval;
+      /** Changes not yet written to the file. */
+      std::vector<Change> pending;
+      /** Guards the pending changes. */
+      std::mutex pendingGuard;
+      /** Used to wake up the writer thread when stopping. */
+      std::condition_variable wakeUp;
+      bool running;
+      std::thread writerThread;
+      /** The students currently in the file, owned by the writer thread. Used in compacting. */
+      std::unordered_map<StudentKey, std::vector<uint8_t>> written;
+      /** Number of records in the file since the last compaction. */
+      std::size_t recordsInFile;
+      std::ofstream file;
+      
+      static const char HeldRecord = 'H';
+      static const char ReleasedRecord = 'R';
+      static const std::string Magic;
+      static const std::string MagicV1;
+      static const std::string TAG;
+   };
+   
+   
+} //namespace
+
+#endif /* defined(__PipesAndFiltersFramework__StudentCheckpointer__) */
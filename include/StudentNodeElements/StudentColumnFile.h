@@ -0,0 +1,155 @@
+//
+//  StudentColumnFile.h
+//  PipesAndFiltersFramework
+//
+//  Created by Antti Juustila on 19.10.2026.
+//  Copyright (c) 2026 Antti Juustila. All rights reserved.
+//
+
+#ifndef __PipesAndFiltersFramework__StudentColumnFile__
+#define __PipesAndFiltersFramework__StudentColumnFile__
+
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+namespace OHARStudent {
+   
+   class StudentDataItem;
+   
+   /**
+    The columnar binary report file of graded students. The file starts with the magic
+    string, followed by one block per column, each block starting at an 8 byte boundary:
+    <ul>
+    <li>string columns (id, study program): row count + 1 offsets (uint64) into the
+    characters following the offsets,</li>
+    <li>number columns (exam, exercise points total, course project, grade): row count int32 values.</li>
+    </ul>
+    After the blocks comes the footer index: byte order mark (uint32), column count (uint32),
+    row count (uint64) and for each column its id, type (uint32 each), offset and length (uint64 each)
+    in the file. The file ends with the offset of the footer (uint64) and the magic string.
+    Values are in the byte order of the host which wrote the file, so that the number columns
+    can be used directly from a memory mapped file.
+    */
+   namespace StudentColumnFile {
+      /** The columns in the file. */
+      enum Column : uint32_t {
+         Id = 0,
+         StudyProgram,
+         ExamPoints,
+         ExercisePoints,
+         CourseProjectPoints,
+         Grade,
+         ColumnCount
+      };
+      /** The types of the column blocks. */
+      enum ColumnType : uint32_t {
+         StringColumn = 1,
+         Int32Column = 2
+      };
+      /** The magic string at the beginning and end of the file. */
+      extern const std::string Magic;
+      /** Written as is into the footer; reads back differently on a host with another byte order. */
+      const uint32_t ByteOrderMark = 0x01020304;
+   }
+   
+   /**
+    Writes graded students into a columnar binary report file (see StudentColumnFile).
+    Each column is streamed into its own temporary spool file next to the report file as the
+    students are written, so the memory used does not grow with the report. When the writer is
+    closed or destroyed, the spool files are copied into a temporary file with the footer index,
+    which then replaces the report file, and the spool files are removed.
+    */
+   class StudentColumnWriter {
+   public:
+      StudentColumnWriter(const std::string & fileName);
+      ~StudentColumnWriter();
+      
+      void write(const StudentDataItem & student);
+      bool close();
+      
+   private:
+      /** A temporary file one column (or the offsets of a string column) is streamed into. */
+      struct Spool {
+         std::string fileName;
+         std::ofstream file;
+         uint64_t bytes = 0;
+         bool open(const std::string & name);
+         void append(const void * data, std::size_t length);
+      };
+      /** A string column: the offsets where the rows start, and the characters of all rows. */
+      struct StringColumn {
+         Spool offsets;
+         Spool characters;
+         void append(const std::string & value);
+      };
+      
+      bool copySpool(std::ofstream & out, Spool & spool);
+      void removeSpools();
+      
+      /** The report file. */
+      std::string fileName;
+      StringColumn ids;
+      StringColumn studyPrograms;
+      Spool examPoints;
+      Spool exercisePoints;
+      Spool courseProjectPoints;
+      Spool grades;
+      uint64_t rowCount;
+      /** False if the spool files could not be opened; nothing is written then. */
+      bool spooling;
+      /** True when the file has been written. */
+      bool closed;
+      /** Guards the columns, since several threads may write students. */
+      std::mutex columnGuard;
+      
+      static const std::string TAG;
+   };
+   
+   /**
+    Reads a columnar binary report file (see StudentColumnFile) by memory mapping it.
+    Single columns can be scanned without touching the others, and without parsing.
+    */
+   class StudentColumnReader {
+   public:
+      StudentColumnReader();
+      ~StudentColumnReader();
+      StudentColumnReader(const StudentColumnReader &) = delete;
+      StudentColumnReader & operator = (const StudentColumnReader &) = delete;
+      
+      bool open(const std::string & fileName);
+      void close();
+      
+      std::size_t getRowCount() const;
+      std::string_view getString(StudentColumnFile::Column column, std::size_t row) const;
+      const int32_t * getNumbers(StudentColumnFile::Column column) const;
+      std::unique_ptr<StudentDataItem> getStudent(std::size_t row) const;
+      
+   private:
+      /** Location of a column block in the mapped file. */
+      struct Block {
+         uint32_t type = 0;
+         const char * begin = nullptr;
+         uint64_t length = 0;
+      };
+      
+      bool readIndex(const std::string & fileName);
+      
+      /** The mapped file, null when no file is open. */
+      const char * mapping;
+      std::size_t mappingSize;
+      std::size_t rowCount;
+      Block blocks[StudentColumnFile::ColumnCount];
+      
+      static const std::string TAG;
+   };
+   
+   
+} //namespace
+
+#endif /* defined(__PipesAndFiltersFramework__StudentColumnFile__) */
@@ -9,21 +9,62 @@
 #ifndef __PipesAndFiltersFramework__StudentDataItem__
 #define __PipesAndFiltersFramework__StudentDataItem__
 
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
 #include <ostream>
+#include <vector>
 
 #include <nlohmann/json.hpp>
 
 #include <ProcessorNode/DataItem.h>
 
+#include <StudentNodeElements/StudentKey.h>
+
 
 namespace OHARStudent {
 
 	
    class GradeCalculator;
+   struct GradingPolicy;
+   
+   /**
+    The grading policy the calling thread uses, gotten from StudentDataItem::getGradingPolicy.
+    Refers to the thread's own copy of the policy, so getting it does not touch the reference
+    count shared by all the threads. The policy is not deleted while the object exists, even if
+    a new one is published, so keep the object only while grading and in the thread that got it.
+    */
+   class GradingPolicyRef {
+   public:
+      ~GradingPolicyRef();
+      GradingPolicyRef(const GradingPolicyRef &) = delete;
+      GradingPolicyRef & operator = (const GradingPolicyRef &) = delete;
+      
+      /** @returns True if there is a grading policy. */
+      explicit operator bool() const { return policy != nullptr; }
+      const GradingPolicy & operator * () const { return *policy; }
+      const GradingPolicy * operator -> () const { return policy; }
+      
+   private:
+      friend class StudentDataItem;
+      explicit GradingPolicyRef(const GradingPolicy * usedPolicy) : policy(usedPolicy) {}
+      
+      const GradingPolicy * policy;
+   };
 
    /**
     A class for handling student data in a ProcessorNode and
     associated classes there (DataHandler, Networker classes etc.).
+    <p>
+    A student can also be parsed lazily, with parseLazily (tsv) or parseJsonLazily (JSON).
+    Then only the id is parsed, and the original record is kept; the other fields are
+    decoded from it when a getter or setter first needs them. A student parsed from JSON
+    also keeps the original JSON until it is modified, so that a node just passing the student
+    on can send the original bytes without encoding them again (see getSourceJson).
+    Decoding happens in const getters, so several threads may read the same student: the first
+    one decodes it, and the others wait until it has been decoded. As usual, modifying a student
+    needs exclusive access.
     */
    class StudentDataItem : public OHARBase::DataItem {
    public:
@@ -34,8 +75,16 @@ namespace OHARStudent {
       virtual std::unique_ptr<OHARBase::DataItem> clone() const override;
       
       virtual bool parse(const std::string & fromString, const std::string & contentType) override;
+      bool parseLazily(const std::string & fromString, const std::string & contentType);
+      bool parse(const std::string & fromString, const std::string & contentType, std::vector<uint32_t> columnStarts);
+      bool parseLazily(const std::string & fromString, const std::string & contentType, std::vector<uint32_t> columnStarts);
+      bool parseJsonLazily(const std::string & json);
+      const std::string * getSourceJson() const;
       bool addFrom(const OHARBase::DataItem & another) override;
 
+      void setId(const std::string & theId);
+      const StudentKey & getKey() const;
+      
       const std::string & getName() const;
       const std::string & getStudyProgram() const;
       int getExamPoints() const;
@@ -43,6 +92,7 @@ namespace OHARStudent {
       const std::vector<int> & getExercisePoints() const;
       int getCourseProjectPoints() const;
       int getGrade() const;
+      uint32_t getGradePolicyVersion() const;
       
       void setName(const std::string & theName);
       void setStudyProgram(const std::string & theDept);
@@ -55,16 +105,51 @@ namespace OHARStudent {
        @param g The grade value, from 0-5 (zero being failed).
        */
       void setGrade(int g);
+      void setGradePolicyVersion(uint32_t version);
       void calculateGrade();
+      void calculateGrade(const GradingPolicy & policy);
       
       bool operator == (const StudentDataItem & item) const;
       bool operator != (const StudentDataItem & item) const;
+      bool operator < (const StudentDataItem & item) const;
       
-      static void setGradeCalculator(GradeCalculator * calc);
+      static uint32_t setGradeCalculator(GradeCalculator * calc);
+      static uint32_t setGradeCalculator(std::shared_ptr<GradeCalculator> calc);
+      static bool removeGradeCalculator(uint32_t version);
+      static GradingPolicyRef getGradingPolicy();
       
    protected:
       
    private:
+      /** The format of the raw record waiting to be decoded. Busy while a thread decodes
+       (or copies) the raw record; the other threads then wait. */
+      enum class RawFormat : uint8_t { None, Tsv, Json, Busy };
+      
+      /** Decodes the fields from the raw record, if not decoded yet. */
+      void ensureDecoded() const {
+         if (rawFormat.load(std::memory_order_acquire) != RawFormat::None) {
+            decode();
+         }
+      }
+      void decode() const;
+      RawFormat claimRaw() const;
+      void decodeFields(RawFormat format);
+      void modified();
+      std::string column(std::size_t index) const;
+      
+      /** The raw record (tsv line or JSON) the fields are decoded from when first needed. */
+      std::shared_ptr<const std::string> rawRecord;
+      /** Offsets of the columns in a tsv raw record. */
+      std::vector<uint32_t> columnOffsets;
+      /** Content type of a tsv raw record. */
+      std::string rawContentType;
+      /** Format of the raw record, None when the fields have been decoded. */
+      mutable std::atomic<RawFormat> rawFormat;
+      /** The JSON the student was parsed from, kept until the student is modified. */
+      std::shared_ptr<const std::string> sourceJson;
+      
+      /** The student id in compact form, kept in sync with the id by setId, the only place the id is set. */
+      StudentKey  key;
       /** The name of the student. */
       std::string name;
       /** The department or curriculum where the student studies. */
@@ -73,13 +158,26 @@ namespace OHARStudent {
       int         examPoints;
       /** The points student got from participating in exercises. */
       std::vector<int> exercisePoints;
+      /** Sum of the exercise points, kept up to date when the points change. */
+      int         exercisePointsTotal;
       /** The points student got from the exercise work. */
       int         courseProjectPoints;
       /** The final grade student gets from the course. */
       int         grade;
+      /** The version of the grading policy which gave the grade, zero if not known. */
+      uint32_t    gradePolicyVersion;
+      
+      friend class GradingPolicyRef;
+      static void releaseGradingPolicy();
       
-      /** A calculator object to calculate the final grade for the student. */
-      static GradeCalculator * calculator;
+      /** The grading policy used to calculate the final grade for the students. Changed and
+       copied under policyGuard; graders use their thread's copy (see getGradingPolicy). */
+      static std::shared_ptr<const GradingPolicy> gradingPolicy;
+      static std::mutex policyGuard;
+      /** Incremented whenever gradingPolicy changes, so threads know when to copy it again. */
+      static std::atomic<uint64_t> policyGeneration;
+      /** The version of the last published grading policy. */
+      static std::atomic<uint32_t> lastPolicyVersion;
       
       static const std::string TAG;
    };
@@ -0,0 +1,88 @@
+//
+//  StudentFileFollower.h
+//  PipesAndFiltersFramework
+//
+//  Created by Antti Juustila on 19.10.2026.
+//  Copyright (c) 2026 Antti Juustila. All rights reserved.
+//
+
+#ifndef __PipesAndFiltersFramework__StudentFileFollower__
+#define __PipesAndFiltersFramework__StudentFileFollower__
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <sys/types.h>
+
+#include <StudentNodeElements/StudentFileReader.h>
+
+namespace OHARBase {
+   class DataReaderObserver;
+}
+
+namespace OHARStudent {
+   
+   /**
+    Follows a student data file like "tail -f": first reads the file, then waits for rows to be
+    appended to it and passes only the new complete lines to the observer. The file is kept open
+    and the offset of the last consumed byte is remembered, so nothing is read twice.
+    <p>
+    Several files are followed in one thread with followAll. On Linux, one inotify descriptor
+    with a watch for each file (and its directory, to notice rotation) wakes up the thread when
+    a file changes, and only the files changed are read; elsewhere (or if inotify is not
+    available) the files are polled. If a file is truncated, it is read again from the beginning.
+    If a file is rotated (replaced by a new file with the same name), the rows still in the old
+    file are read first, and then the new file from the beginning. In both cases the first line
+    is again read as the content type.
+    */
+   class StudentFileFollower {
+   public:
+      StudentFileFollower(OHARBase::DataReaderObserver & observer, const std::string & fileName);
+      ~StudentFileFollower();
+      
+      void setLazyParsing(bool lazy);
+      void follow(const std::atomic<bool> & cancelled, std::chrono::milliseconds pollInterval = std::chrono::milliseconds(500));
+      static void followAll(const std::vector<StudentFileFollower*> & followers, const std::atomic<bool> & cancelled,
+                            std::chrono::milliseconds pollInterval = std::chrono::milliseconds(500));
+      std::size_t readAppended();
+      uint64_t getOffset() const;
+      
+   private:
+      StudentFileFollower(const StudentFileFollower &) = delete;
+      StudentFileFollower & operator = (const StudentFileFollower &) = delete;
+      
+      bool openFile();
+      void closeFile();
+      std::size_t readLines(bool endOfFile);
+      std::size_t handleLine(std::string line);
+      void watchFile();
+      void restart();
+      
+      OHARBase::DataReaderObserver & observer;
+      std::string fileName;
+      StudentFileReader reader;
+      /** The content type, read from the first line of the file. */
+      std::string contentType;
+      /** The file being followed, -1 if not open. */
+      int fileFd;
+      /** Bytes read after the last complete line. */
+      std::string partialLine;
+      /** Offset of the first byte not yet consumed (the partial line starts here). */
+      uint64_t offset;
+      /** Identity of the open file, to detect rotation. */
+      dev_t device;
+      ino_t inode;
+      /** The inotify descriptor of followAll and the watch of the open file, -1 if none. */
+      int notifyFd;
+      int fileWatch;
+      
+      static const std::string TAG;
+   };
+   
+   
+} //namespace
+
+#endif /* defined(__PipesAndFiltersFramework__StudentFileFollower__) */
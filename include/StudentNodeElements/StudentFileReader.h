@@ -9,25 +9,56 @@
 #ifndef __PipesAndFiltersFramework__StudentFileReader__
 #define __PipesAndFiltersFramework__StudentFileReader__
 
+#include <atomic>
+#include <cstdint>
+#include <memory>
 #include <string>
 
 #include <ProcessorNode/DataFileReader.h>
 #include <ProcessorNode/DataItem.h>
 
+#include <StudentNodeElements/AllocationTracker.h>
+
 namespace OHARStudent {
 
+   class MetricCounter;
+   class StudentDataItem;
+
    /**
     The reader class to read student data from a file.
+    <p>
+    readFile reads the file in large chunks and locates the tabs and newlines of a whole chunk at
+    once with DelimiterScanner, so the records are split without going through the bytes one by
+    one. Exercise points are converted directly from the located columns.
     */
    class StudentFileReader : public OHARBase::DataFileReader {
    public:
       StudentFileReader(OHARBase::DataReaderObserver & obs);
       virtual ~StudentFileReader();
       
+      void setCancelFlag(const std::atomic<bool> * flag);
+      void setLazyParsing(bool lazy);
+      bool readFile(const std::string & fileName);
+      std::unique_ptr<OHARBase::DataItem> parseLine(const std::string & str, const std::string & contentType);
+      
    protected:
       std::unique_ptr<OHARBase::DataItem> parse(const std::string & str, const std::string & contentType) override;
       
    private:
+      std::unique_ptr<StudentDataItem> parseRecord(const char * buffer, uint32_t begin, uint32_t end, const uint32_t * tabs, std::size_t tabCount, const std::string & contentType);
+      std::unique_ptr<StudentDataItem> parseExercises(const char * buffer, uint32_t begin, uint32_t end, const uint32_t * tabs, std::size_t tabCount);
+      
+      /** The size of the chunks the file is read and scanned in. */
+      static const std::size_t ReadChunkSize = 1024 * 1024;
+      /** If set and true, reading has been cancelled and lines are not parsed anymore. */
+      const std::atomic<bool> * cancelFlag;
+      /** If true, only the ids are parsed when reading; other values when first needed. */
+      bool lazyParsing;
+      /** Metrics: lines parsed and lines which could not be parsed. */
+      MetricCounter & parsedCount;
+      MetricCounter & parseErrorCount;
+      /** Counts the allocations made while handling data, if allocation accounting is enabled. */
+      AllocationStage allocationStage;
       static const std::string TAG;
    };
 
@@ -0,0 +1,50 @@
+//
+//  StudentFileSet.h
+//  PipesAndFiltersFramework
+//
+//  Created by Antti Juustila on 19.10.2026.
+//  Copyright (c) 2026 Antti Juustila. All rights reserved.
+//
+
+#ifndef __PipesAndFiltersFramework__StudentFileSet__
+#define __PipesAndFiltersFramework__StudentFileSet__
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+namespace OHARBase {
+   class DataReaderObserver;
+}
+
+namespace OHARStudent {
+   
+   /**
+    Reads a set of student data files into the same observer (handler). The node's data file
+    configuration may name several files, separated by commas, and each name may be a glob pattern
+    (e.g. "data/exams-*.txt"). The files are read concurrently, each in its own thread with its own
+    StudentFileReader, with a bounded number of files read at the same time.
+    <p>
+    Each file has its own content type on the first line, as usual. Files of different
+    content types can be read together by handlers passing each row on as such
+    (PlainStudentFileHandler). StudentHandler joins each file row with the data of the
+    same student from the network, so it requires all its files to have the same content
+    type (see haveSameContentType); otherwise a student could be joined before the rows of
+    the other files have arrived.
+    */
+   class StudentFileSet {
+   public:
+      static std::vector<std::string> expand(const std::string & fileSpec);
+      static std::string contentTypeOf(const std::string & file);
+      static bool haveSameContentType(const std::vector<std::string> & files);
+      static std::size_t readAll(OHARBase::DataReaderObserver & observer, const std::vector<std::string> & files, std::size_t maxParallel, const std::atomic<bool> * cancelFlag, bool lazyParsing = false);
+      static void followAll(OHARBase::DataReaderObserver & observer, const std::vector<std::string> & files, const std::atomic<bool> & cancelled, bool lazyParsing = false);
+      
+   private:
+      static const std::string TAG;
+   };
+   
+   
+} //namespace
+
+#endif /* defined(__PipesAndFiltersFramework__StudentFileSet__) */
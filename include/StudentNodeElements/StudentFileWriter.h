@@ -10,25 +10,54 @@
 #define __PipesAndFiltersFramework__StudentFileWriter__
 
 #include <fstream>
+#include <memory>
+#include <mutex>
+#include <string_view>
+
+#include <StudentNodeElements/StudentRecordFormatter.h>
 
 
 namespace OHARStudent {
 
 	
    class StudentDataItem;
+   class CompressedOutput;
 
    /** A class for writing student data into a file.
     */
    class StudentFileWriter {
    public:
-      StudentFileWriter(const std::string & fileName);
+      /** How the file is compressed. */
+      enum class Compression {
+         ByExtension,
+         None,
+         Gzip,
+         Zlib
+      };
+      
+      StudentFileWriter(const std::string & fileName, Compression compression = Compression::ByExtension);
       virtual ~StudentFileWriter();
       
       virtual void write(const StudentDataItem * student);
+      bool flush();
+      
+      static Compression compressionFor(const std::string & fileName);
       
    private:
+      bool isOpen() const;
+      void writeBuffer();
+      void output(std::string_view text);
+      
+      /** The buffered records are written to the file when there are this many bytes. */
+      static const std::size_t WriteChunkSize = 64 * 1024;
       /** The output file stream to write into. */
       std::ofstream file;
+      /** If the file is compressed, compresses the data and writes it into the file instead of the stream. */
+      std::unique_ptr<CompressedOutput> compressed;
+      /** Formats the records into a buffer until they are written to the file. */
+      StudentRecordFormatter formatter;
+      /** Guards the buffer, since several threads may write students. */
+      std::mutex bufferGuard;
       
    };
 	
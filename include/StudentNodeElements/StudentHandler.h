@@ -9,12 +9,22 @@
 #ifndef __PipesAndFiltersFramework__ExerciseMergerHandler__
 #define __PipesAndFiltersFramework__ExerciseMergerHandler__
 
-#include <list>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
 
 #include <ProcessorNode/DataHandler.h>
 #include <ProcessorNode/DataReaderObserver.h>
 #include <ProcessorNode/DataItem.h>
 
+#include <StudentNodeElements/StudentKey.h>
+#include <StudentNodeElements/FlowControl.h>
+#include <StudentNodeElements/ReaderExecutor.h>
+#include <StudentNodeElements/StatusReporter.h>
+#include <StudentNodeElements/AllocationTracker.h>
+
 namespace OHARBase {
 	class ProcessorNode;
 	class Package;
@@ -37,9 +47,27 @@ namespace OHARStudent {
 
 	
    class StudentDataItem;
+   class StudentCheckpointer;
+   class StudentIngestQueue;
+   class MetricCounter;
+   class MetricGauge;
+   class MetricHistogram;
 
    /** A DataHandler class for handling student data in a ProcessorNode.
     This class handles data arriving from other ProcessorNodes or read from a data file.
+    A student is held until the data of the same student arrives from the other source;
+    a student arriving again from the same source is combined into the held student,
+    which keeps waiting for the other source.
+    <p>
+    The batch of the node ends when the data files have been read and the previous node has
+    passed on the end of its batch, a "flush" control package (which the network writer sends on
+    to the next node like the other control packages). Only then all the students that can join
+    have been passed on, and the handler passes on its own "flush" (see passEndOfBatch). In
+    follow mode the files do not end, and the "flush" of the previous node ends the batch.
+    <p>
+    By default the threads passing students merge them under a lock. With enableIngestQueue,
+    the threads instead push the students into a lock free queue, and one merge thread owning
+    the held students merges them and passes the merged students on.
     */
    class StudentHandler : public OHARBase::DataHandler, public OHARBase::DataReaderObserver {
    public:
@@ -51,17 +79,66 @@ namespace OHARStudent {
       // From DataReaderObserver
       void handleNewItem(std::unique_ptr<OHARBase::DataItem> item) override;
       
+      void setMaxParallelFiles(std::size_t maxFiles);
+      void setFollowMode(bool follow);
+      bool waitForFileRead(std::chrono::milliseconds timeout);
+      void cancelFileRead();
+      void setMaxStatusUpdates(unsigned maxUpdatesPerSecond);
+      void setMaxItemsInFlight(std::size_t maxItems);
+      void enableCheckpoints(const std::string & fileName, std::chrono::milliseconds interval = std::chrono::seconds(5));
+      void enableIngestQueue();
+      
    private:
       void readFile();
+      bool inputEnded(bool files);
+      void passEndOfBatch();
       
-      StudentDataItem * findStudent(const StudentDataItem & which) const;
+      /** A student waiting for the data from the other source. */
+      struct HeldStudent {
+         std::unique_ptr<StudentDataItem> student;
+         StudentSource source;
+      };
+      
+      void mergeStudent(std::unique_ptr<StudentDataItem> newStudent, StudentSource source);
+      HeldStudent * findStudent(const StudentDataItem & which);
+      void combineHeld(HeldStudent & held, const StudentDataItem & newStudent);
       
       /** The ProcessorNode where this handler is residing in. */
       OHARBase::ProcessorNode & node;
       static const std::string TAG;
-      /** This list holds the student data handled by this handler. */
-      std::list<OHARBase::DataItem*> dataItems;
+      /** This container holds the student data handled by this handler, keyed by the student key. */
+      std::unordered_map<StudentKey, HeldStudent> dataItems;
+      /** Guards the held students, unless the ingest queue is enabled and only its merge thread uses them. */
       std::mutex listGuard;
+      /** If checkpoints are enabled, writes the held students into a snapshot file. */
+      std::unique_ptr<StudentCheckpointer> checkpointer;
+      /** The name the metrics of this handler are registered with (see MetricsRegistry::instanceName). */
+      const std::string metricsName;
+      /** Limits how far the file reading thread can run ahead of the following handlers. */
+      FlowControl readerFlow;
+      /** How many data files are read at the same time. */
+      std::atomic<std::size_t> maxParallelFiles;
+      /** If true, data files are followed for appended rows instead of read once. */
+      std::atomic<bool> followFiles;
+      /** The inputs of the current batch which have ended, see inputEnded. */
+      std::mutex batchGuard;
+      bool filesRead;
+      bool previousNodeEnded;
+      
+      /** Metrics: students received, merged, held and the time spent handling them. */
+      MetricCounter & consumedCount;
+      MetricCounter & mergedCount;
+      MetricGauge & heldCount;
+      MetricHistogram & consumeTime;
+      /** Counts the allocations made while handling data, if allocation accounting is enabled. */
+      AllocationStage allocationStage;
+      /** Shows the progress in the node's UI, at a limited rate. */
+      StatusReporter status;
+      /** If enabled, hands the students to the merge thread. Destroyed after the reader, but
+       before the members the merge thread uses. */
+      std::unique_ptr<StudentIngestQueue> ingestQueue;
+      /** Reads the data file. Declared last, so that reading stops before the other members are destroyed. */
+      ReaderExecutor reader;
       
    };
 
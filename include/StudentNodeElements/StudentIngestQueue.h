@@ -0,0 +1,100 @@
+//
+//  StudentIngestQueue.h
+//  PipesAndFiltersFramework
+//
+//  Created by Antti Juustila on 19.10.2026.
+//  Copyright (c) 2026 Antti Juustila. All rights reserved.
+//
+
+#ifndef __PipesAndFiltersFramework__StudentIngestQueue__
+#define __PipesAndFiltersFramework__StudentIngestQueue__
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include <StudentNodeElements/StudentKey.h>
+#include <StudentNodeElements/FlowControl.h>
+
+namespace OHARStudent {
+   
+   class StudentDataItem;
+   class MetricGauge;
+   
+   /**
+    A multi-producer, single-consumer queue handing students from the threads receiving them
+    (network threads, file readers) to one merge thread owned by the queue. Pushing is lock free:
+    a producer only swaps the queue head with an atomic exchange, and never waits for the merge
+    thread. The merge thread calls the consumer function for each student in the order pushed by
+    each producer, so the state the consumer uses needs no locking when only the merge thread
+    touches it.
+    <p>
+    When the queue is empty, the merge thread sleeps on a condition variable; only then does a
+    producer take a mutex, to wake it up. When the queue is destroyed, the students still in the
+    queue are consumed before the merge thread ends.
+    <p>
+    The queue is unbounded. Producers which should not run ahead of the merge thread limit
+    themselves with FlowControl; the credit pushed with a student is released after the
+    consumer has handled it.
+    */
+   class StudentIngestQueue {
+   public:
+      /** Handles one student in the merge thread. The credit is current while the function runs. */
+      typedef std::function<void(std::unique_ptr<StudentDataItem> student, StudentSource source)> Consumer;
+      
+      StudentIngestQueue(const std::string & handlerName, Consumer consumer);
+      ~StudentIngestQueue();
+      
+      void push(std::unique_ptr<StudentDataItem> student, StudentSource source, FlowCredit credit);
+      bool waitUntilDrained(std::chrono::milliseconds timeout);
+      std::size_t getSize() const;
+      
+   private:
+      StudentIngestQueue(const StudentIngestQueue &) = delete;
+      StudentIngestQueue & operator = (const StudentIngestQueue &) = delete;
+      
+      /** A queued student. The stub node, kept in the queue when it is empty, holds no student. */
+      struct Node {
+         std::atomic<Node*> next{nullptr};
+         std::unique_ptr<StudentDataItem> student;
+         StudentSource source = StudentSource::Unknown;
+         FlowCredit credit;
+      };
+      
+      void pushNode(Node * node);
+      Node * pop();
+      bool isEmpty() const;
+      void run();
+      
+      Consumer consumer;
+      /** The last node pushed. Producers swap it. */
+      std::atomic<Node*> head;
+      /** The next node to pop. Only used by the merge thread. */
+      Node * tail;
+      Node stub;
+      /** Students pushed and students consumed, for the queue size and draining. */
+      std::atomic<uint64_t> pushedCount;
+      std::atomic<uint64_t> consumedCount;
+      /** The smallest consumed count a waitUntilDrained caller waits for, NoDrainTarget if none. */
+      std::atomic<uint64_t> drainTarget;
+      static constexpr uint64_t NoDrainTarget = UINT64_MAX;
+      /** True while the merge thread is sleeping or about to sleep, waiting for students. */
+      std::atomic<bool> mergeThreadIdle;
+      std::atomic<bool> stopping;
+      std::mutex idleGuard;
+      std::condition_variable pushed;
+      std::condition_variable drained;
+      MetricGauge & sizeGauge;
+      std::thread mergeThread;
+   };
+   
+   
+} //namespace
+
+#endif /* defined(__PipesAndFiltersFramework__StudentIngestQueue__) */
@@ -11,6 +11,8 @@
 
 #include <ProcessorNode/DataHandler.h>
 
+#include <StudentNodeElements/AllocationTracker.h>
+
 // Forward declaration
 namespace OHARBase {
 	class Package;
@@ -18,6 +20,9 @@ namespace OHARBase {
 
 namespace OHARStudent {
 
+class MetricCounter;
+class MetricHistogram;
+
 /** Handles student data input, arriving from the network. 
  Class receives (in consume method) a Package object, which has the received
  data (non-parsed JSON) in a string. This handler then parses the data from
@@ -35,6 +40,14 @@ public:
    bool consume(OHARBase::Package & data) override;
    
 private:
+   /** The name the metrics of this handler are registered with (see MetricsRegistry::instanceName). */
+   const std::string metricsName;
+   /** Metrics: students received, payloads which could not be parsed and the time spent parsing. */
+   MetricCounter & consumedCount;
+   MetricCounter & parseErrorCount;
+   MetricHistogram & consumeTime;
+   /** Counts the allocations made while handling data, if allocation accounting is enabled. */
+   AllocationStage allocationStage;
    static const std::string TAG;
 };
 	
@@ -0,0 +1,78 @@
+//
+//  StudentKey.h
+//  PipesAndFiltersFramework
+//
+//  Created by Antti Juustila on 19.10.2026.
+//  Copyright (c) 2026 Antti Juustila. All rights reserved.
+//
+
+#ifndef __PipesAndFiltersFramework__StudentKey__
+#define __PipesAndFiltersFramework__StudentKey__
+
+#include <cstdint>
+#include <functional>
+#include <string>
+
+
+namespace OHARStudent {
+
+   /**
+    A compact key identifying a student. Student ids are usually fixed format
+    numeric strings, and those are packed into a single 64 bit integer when the key
+    is created. Hashing, equality and ordering of such keys are then plain integer
+    operations. Ids which are not numeric (or are too long to pack) are kept as
+    strings, so any id can still be used as a key.
+    <p>
+    Numeric keys are ordered first by the number of digits, then by value. For fixed
+    format ids (same number of digits) this is the same order as the string order.
+    All numeric keys are ordered before the string keys.
+    */
+   class StudentKey {
+   public:
+      StudentKey();
+      explicit StudentKey(const std::string & id);
+      
+      bool isNumeric() const;
+      uint64_t getPacked() const;
+      std::string toString() const;
+      std::size_t hash() const;
+      
+      bool operator == (const StudentKey & other) const;
+      bool operator != (const StudentKey & other) const;
+      bool operator < (const StudentKey & other) const;
+      
+      /** Maximum number of digits in an id that can be packed into the integer. */
+      static const int MaxDigits = 15;
+      
+   private:
+      /** Packed numeric id: flag bit, digit count and the value. Zero if not numeric. */
+      uint64_t packed;
+      /** The id as a string, used only if the id could not be packed. */
+      std::string fallback;
+   };
+   
+   /**
+    Where a student held for joining came from. StudentHandler joins data from the
+    previous node with data read from the files, so only students from different
+    sources are joined. Unknown is used for students restored from old checkpoints,
+    which did not record the source; those join with either source.
+    */
+   enum class StudentSource : uint8_t {
+      Unknown = 0,
+      Network = 1,
+      File = 2
+   };
+   
+   
+} //namespace
+
+namespace std {
+   /** Hash support for using StudentKey in unordered containers. */
+   template <> struct hash<OHARStudent::StudentKey> {
+      std::size_t operator()(const OHARStudent::StudentKey & key) const {
+         return key.hash();
+      }
+   };
+}
+
+#endif /* defined(__PipesAndFiltersFramework__StudentKey__) */
@@ -11,12 +11,17 @@
 
 #include <ProcessorNode/DataHandler.h>
 
+#include <StudentNodeElements/AllocationTracker.h>
+
 namespace OHARBase {
 	class Package;
 }
 
 namespace OHARStudent {
 	
+   class MetricCounter;
+   class MetricHistogram;
+   
 	/**
     This class converts the data from internal Node format to
     external JSON format to be sent over to network to a following Node.
@@ -29,6 +34,13 @@ namespace OHARStudent {
 		bool consume(OHARBase::Package & data) override;
 		
 	private:
+      /** The name the metrics of this handler are registered with (see MetricsRegistry::instanceName). */
+      const std::string metricsName;
+      /** Metrics: students converted to JSON and the time spent converting. */
+      MetricCounter & encodedCount;
+      MetricHistogram & consumeTime;
+      /** Counts the allocations made while handling data, if allocation accounting is enabled. */
+      AllocationStage allocationStage;
 		static const std::string TAG;
 	};
 	
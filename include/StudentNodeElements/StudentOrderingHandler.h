@@ -0,0 +1,106 @@
+//
+//  StudentOrderingHandler.h
+//  PipesAndFiltersFramework
+//
+//  Created by Antti Juustila on 19.10.2026.
+//  Copyright (c) 2026 Antti Juustila. All rights reserved.
+//
+
+#ifndef __PipesAndFiltersFramework__StudentOrderingHandler__
+#define __PipesAndFiltersFramework__StudentOrderingHandler__
+
+#include <cstdint>
+#include <functional>
+#include <iosfwd>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <ProcessorNode/DataHandler.h>
+
+#include <StudentNodeElements/AllocationTracker.h>
+
+namespace OHARBase {
+   class ProcessorNode;
+   class Package;
+}
+
+namespace OHARStudent {
+   
+   class StudentDataItem;
+   class MetricCounter;
+   class MetricGauge;
+   
+   /**
+    Restores the order of the students before they are written: placed in front of the
+    StudentWriterHandler, it holds the students arriving in any order (from parallel grading
+    workers or partitions), and passes them on sorted by the student id (StudentKey order)
+    when flushed.
+    <p>
+    Students are collected in memory until the memory budget is exceeded; then the students
+    in memory are sorted and written into a run file (external merge sort). When flushed,
+    the students in memory and in the run files are merged (k-way merge) and passed to the
+    next handlers. The handler is flushed by a "flush" control package, which the file handlers
+    pass on when they have read the data files (end of the batch), or by calling flush().
+    Students not flushed when the handler is destroyed are not passed on; they are written
+    into a run file, and the run files are kept in the spill directory, with an error logged.
+    <p>
+    If a run file cannot be read to its end, merging it into another run file fails and the
+    original run files are kept. When flushing, the students that could be read are passed on
+    and the damaged run file is left in the spill directory, with an error logged.
+    */
+   class StudentOrderingHandler : public OHARBase::DataHandler {
+   public:
+      StudentOrderingHandler(OHARBase::ProcessorNode & myNode, std::size_t memoryBudget = 64 * 1024 * 1024, const std::string & spillDirectory = "");
+      virtual ~StudentOrderingHandler();
+      
+      bool consume(OHARBase::Package & data) override;
+      
+      void flush();
+      
+   private:
+      class RunReader;
+      
+      static std::size_t estimateSize(const StudentDataItem & student);
+      static void writeRecord(std::ostream & file, const StudentDataItem & student);
+      static bool mergeRuns(std::vector<std::unique_ptr<RunReader>> & runs, std::vector<std::unique_ptr<StudentDataItem>> & inMemory,
+                            const std::function<void(std::unique_ptr<StudentDataItem>)> & emit);
+      void spill(std::vector<std::unique_ptr<StudentDataItem>> students);
+      void mergeRunFiles();
+      std::string nextRunFileName();
+      
+      /** When there are this many run files, they are merged into one. */
+      static const std::size_t MaxRunFiles = 64;
+      
+      /** The ProcessorNode where this handler is residing in. */
+      OHARBase::ProcessorNode & node;
+      const std::size_t memoryBudget;
+      std::string spillDirectory;
+      
+      /** The students held in memory, and their estimated size. */
+      std::vector<std::unique_ptr<StudentDataItem>> students;
+      std::size_t bufferedBytes;
+      std::mutex bufferGuard;
+      
+      /** The sorted run files written when the memory budget was exceeded. */
+      std::vector<std::string> runFiles;
+      uint64_t runsWritten;
+      /** Taken while writing or merging the run files. Taken before bufferGuard, if both are needed. */
+      std::mutex runGuard;
+      
+      /** The name the metrics of this handler are registered with (see MetricsRegistry::instanceName). */
+      const std::string metricsName;
+      /** Metrics: students held in memory, run files written and students passed on in order. */
+      MetricGauge & bufferedCount;
+      MetricCounter & spilledRuns;
+      MetricCounter & releasedCount;
+      /** Counts the allocations made while handling data, if allocation accounting is enabled. */
+      AllocationStage allocationStage;
+      static const std::string TAG;
+   };
+   
+   
+} //namespace
+
+#endif /* defined(__PipesAndFiltersFramework__StudentOrderingHandler__) */
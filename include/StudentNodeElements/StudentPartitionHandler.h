@@ -0,0 +1,90 @@
+//
+//  StudentPartitionHandler.h
+//  PipesAndFiltersFramework
+//
+//  Created by Antti Juustila on 19.10.2026.
+//  Copyright (c) 2026 Antti Juustila. All rights reserved.
+//
+
+#ifndef __PipesAndFiltersFramework__StudentPartitionHandler__
+#define __PipesAndFiltersFramework__StudentPartitionHandler__
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <ProcessorNode/DataHandler.h>
+
+#include <StudentNodeElements/AllocationTracker.h>
+
+namespace OHARBase {
+   class Package;
+   class ProcessorNode;
+}
+
+namespace OHARStudent {
+   
+   class StudentKey;
+   class PackageWorkerPool;
+   class MetricCounter;
+   class MetricGauge;
+   
+   /**
+    Splits the stream of students to several replicas, so that the merging and
+    grading stages can be run in parallel replicas. Each student is routed by a consistent
+    hash (jump consistent hash) of the student id, so the data of a student from any source
+    always goes to the same replica, and the joins done there stay correct.
+    <p>
+    Each replica is a ProcessorNode with its own handlers (e.g. a StudentHandler and a GradingHandler),
+    or a node with a handler sending the students to a replica process. Every replica has a queue
+    and a thread of its own, delivering the packages to the first handler of the replica, and then,
+    unless that handler consumed the package, to the following handlers of the replica node. The
+    replicas thus run in parallel, each in the order the packages were routed to it.
+    <p>
+    Control packages (like readfile) are given to all the replicas. The number of students
+    routed to each partition is in the metrics as the counters "partition_N", and the skew
+    (largest partition compared to the average, in percent) as the gauge "skew_percent".
+    Place the handler after StudentInputHandler, since the students are routed by the parsed id.
+    */
+   class StudentPartitionHandler : public OHARBase::DataHandler {
+   public:
+      /** A replica: the node and its first handler, which the packages are delivered to. */
+      struct Replica {
+         OHARBase::ProcessorNode * node;
+         OHARBase::DataHandler * firstHandler;
+      };
+      
+      StudentPartitionHandler(const std::vector<Replica> & replicas);
+      virtual ~StudentPartitionHandler();
+      
+      bool consume(OHARBase::Package & data) override;
+      void drain();
+      
+      std::size_t getPartitionCount() const;
+      std::size_t partitionFor(const StudentKey & key) const;
+      uint64_t getCount(std::size_t partition) const;
+      double getSkew() const;
+      
+      static int32_t jumpHash(uint64_t key, int32_t buckets);
+      
+   private:
+      /** The replicas; fixed when the handler is created, so routing needs no locking. */
+      std::vector<Replica> replicas;
+      /** One single threaded queue per replica, delivering the packages to the replica in order. */
+      std::vector<std::unique_ptr<PackageWorkerPool>> deliveries;
+      /** The name the metrics of this handler are registered with (see MetricsRegistry::instanceName). */
+      const std::string metricsName;
+      /** Metrics: students routed to each partition and the skew of the partitions. */
+      std::vector<MetricCounter*> partitionCounts;
+      MetricCounter & routedCount;
+      MetricGauge & skewPercent;
+      /** Counts the allocations made while handling data, if allocation accounting is enabled. */
+      AllocationStage allocationStage;
+      static const std::string TAG;
+   };
+   
+   
+} //namespace
+
+#endif /* defined(__PipesAndFiltersFramework__StudentPartitionHandler__) */
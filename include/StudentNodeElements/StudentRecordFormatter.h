@@ -0,0 +1,49 @@
+//
+//  StudentRecordFormatter.h
+//  PipesAndFiltersFramework
+//
+//  Created by Antti Juustila on 19.10.2026.
+//  Copyright (c) 2026 Antti Juustila. All rights reserved.
+//
+
+#ifndef __PipesAndFiltersFramework__StudentRecordFormatter__
+#define __PipesAndFiltersFramework__StudentRecordFormatter__
+
+#include <string>
+
+
+namespace OHARStudent {
+   
+   class StudentDataItem;
+   
+   /**
+    Formats student records into the tab separated report format, into a buffer reused from
+    record to record. Numbers are formatted with std::to_chars, without the locale handling of
+    the streams. The format is the same as with operator << of StudentDataItem: id, name,
+    study program, exam points, exercise points total, course project points and grade,
+    separated with tabs and ending in a newline.
+    */
+   class StudentRecordFormatter {
+   public:
+      StudentRecordFormatter() = default;
+      
+      void append(const StudentDataItem & student);
+      
+      /** @returns The formatted records. */
+      const char * data() const { return buffer.data(); }
+      /** @returns The number of bytes in the formatted records. */
+      std::size_t size() const { return buffer.size(); }
+      /** Removes the formatted records, keeping the memory for the next records. */
+      void clear() { buffer.clear(); }
+      
+   private:
+      void appendNumber(int value);
+      
+      /** The formatted records. */
+      std::string buffer;
+   };
+   
+   
+} //namespace
+
+#endif /* defined(__PipesAndFiltersFramework__StudentRecordFormatter__) */
@@ -0,0 +1,99 @@
+//
+//  StudentTracer.h
+//  PipesAndFiltersFramework
+//
+//  Created by Antti Juustila on 19.10.2026.
+//  Copyright (c) 2026 Antti Juustila. All rights reserved.
+//
+
+#ifndef __PipesAndFiltersFramework__StudentTracer__
+#define __PipesAndFiltersFramework__StudentTracer__
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <new>
+#include <string>
+
+#include <StudentNodeElements/StudentKey.h>
+
+
+namespace OHARStudent {
+   
+   class StudentDataItem;
+   
+   /**
+    Opt-in tracing of students passing through the handlers. When enabled, each handler
+    records a span (name, start and duration) for the students it handles. Students are sampled
+    by their key, so a sampled student is traced in every handler (and in every node using the
+    same sampling rate).
+    <p>
+    Spans are recorded into per-thread ring buffers, so recording threads do not contend with each
+    other. When a ring buffer is full, the oldest spans are overwritten. The spans can be exported
+    in the Chrome trace event JSON format, viewable in chrome://tracing or Perfetto.
+    <p>
+    When tracing is disabled, a TraceSpan costs one relaxed atomic load and a branch when
+    created, and a test of its active flag when destroyed.
+    */
+   class StudentTracer {
+   public:
+      static void enable(uint32_t sampleEvery = 1, std::size_t spansPerThread = 65536);
+      static void disable();
+      /** @returns True if tracing is enabled. */
+      static bool isEnabled() { return enabled.load(std::memory_order_relaxed); }
+      static bool isSampled(const StudentKey & key);
+      static void record(const char * name, const StudentKey & key, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end);
+      static bool exportChromeTrace(const std::string & fileName);
+      
+   private:
+      static std::atomic<bool> enabled;
+      static std::atomic<uint32_t> sampleEvery;
+      static std::atomic<std::size_t> spansPerThread;
+   };
+   
+   /**
+    Records a trace span from the creation to the destruction of the object, if tracing is
+    enabled and the student is sampled. The student can be given later with setStudent, if it
+    is not known when the span starts (e.g. when parsing the student).
+    */
+   class TraceSpan {
+   public:
+      explicit TraceSpan(const char * name, const StudentDataItem * student = nullptr) : active(false) {
+         if (StudentTracer::isEnabled()) {
+            begin(name, student);
+         }
+      }
+      ~TraceSpan() {
+         if (active) {
+            end();
+         }
+      }
+      /** Sets the student the span is recorded for, if it was not known when the span started.
+       @param student The student, may be null. */
+      void setStudent(const StudentDataItem * student) {
+         if (active) {
+            assignStudent(student);
+         }
+      }
+      
+   private:
+      TraceSpan(const TraceSpan &) = delete;
+      TraceSpan & operator = (const TraceSpan &) = delete;
+      
+      void begin(const char * name, const StudentDataItem * student);
+      void assignStudent(const StudentDataItem * student);
+      void end();
+      
+      bool active;
+      const char * name;
+      /** Copy of the student's key, since the student may be gone when the span ends. Points to
+       keyStorage once a student is known; the key is only constructed in an active span. */
+      StudentKey * key;
+      alignas(StudentKey) unsigned char keyStorage[sizeof(StudentKey)];
+      std::chrono::steady_clock::time_point start;
+   };
+   
+   
+} //namespace
+
+#endif /* defined(__PipesAndFiltersFramework__StudentTracer__) */
@@ -9,8 +9,16 @@
 #ifndef __PipesAndFiltersFramework__StudentWriterHandler__
 #define __PipesAndFiltersFramework__StudentWriterHandler__
 
+#include <memory>
+#include <mutex>
+#include <string>
+
 #include <ProcessorNode/DataHandler.h>
 
+#include <StudentNodeElements/StatusReporter.h>
+#include <StudentNodeElements/StudentFileWriter.h>
+#include <StudentNodeElements/AllocationTracker.h>
+
 namespace OHARBase {
 	class ProcessorNode;
 	class Package;
@@ -18,23 +26,43 @@ namespace OHARBase {
 
 namespace OHARStudent {
 	
-   class StudentFileWriter;
+   class StudentColumnWriter;
+   class MetricCounter;
+   class MetricHistogram;
 
    /** The DataHandler in the ProcessorNode which handles packages
     containing student data so that the student data is written into a file.
     */
    class StudentWriterHandler : public OHARBase::DataHandler {
    public:
-      StudentWriterHandler(OHARBase::ProcessorNode & myNode);
+      StudentWriterHandler(OHARBase::ProcessorNode & myNode, StudentFileWriter::Compression compression = StudentFileWriter::Compression::ByExtension);
       virtual ~StudentWriterHandler();
       
       bool consume(OHARBase::Package & data) override;
       
+      void enableColumnarOutput(const std::string & fileName);
+      
    private:
       /** The ProcessorNode where this handler is residing in. */
       OHARBase::ProcessorNode & node;
       /** The writer to use in writing the data into the file. */
       StudentFileWriter * writer;
+      /** If columnar output is enabled, writes the students of the batch also into a columnar binary file. */
+      std::unique_ptr<StudentColumnWriter> columnWriter;
+      /** The columnar report file, empty if not enabled, and the number of batches written into it. */
+      std::string columnFileName;
+      unsigned columnBatches;
+      /** Guards the column writer, replaced at the end of each batch. */
+      std::mutex columnGuard;
+      /** The name the metrics of this handler are registered with (see MetricsRegistry::instanceName). */
+      const std::string metricsName;
+      /** Metrics: students written and the time spent writing them. */
+      MetricCounter & writtenCount;
+      MetricHistogram & consumeTime;
+      /** Counts the allocations made while handling data, if allocation accounting is enabled. */
+      AllocationStage allocationStage;
+      /** Shows the number of students written in the node's UI, at a limited rate. */
+      StatusReporter status;
       static const std::string TAG;
    };
 
@@ -17,6 +17,7 @@ namespace OHARStudent {
    class TheUsualGrader : public GradeCalculator {
    public:
       int calculate(const StudentDataItem & source) override;
+      std::string getName() const override;
    };
 
 	
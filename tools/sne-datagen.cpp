@@ -0,0 +1,370 @@
+//
+//  sne-datagen.cpp
+//  PipesAndFiltersFramework
+//
+//  Created by Antti Juustila on 19.10.2026.
+//  Copyright (c) 2026 Antti Juustila. All rights reserved.
+//
+
+// Generates synthetic student data files for load testing the nodes. One file is written
+// for each content type StudentDataItem::parse understands, the first line of each file
+// being the content type, as StudentFileReader expects. The data of a student is derived
+// from the student's number only, so that all the files (and the JSON payloads) agree on it.
+//
+// Usage: sne-datagen [options]
+//   --students N       Number of students (default 1000).
+//   --exercises N      Number of exercise columns in exercisedata (default 10).
+//   --overlap R        Fraction 0..1 of the students included in the exercise, exercise work
+//                      and exam files (default 1). Studentdata and summarydata have all students.
+//   --order O          Order of the rows: sorted, reverse or random (default random).
+//   --skew N           With sorted and reverse order, rows are moved up to N rows away from their
+//                      sorted place, differently in each file (default 0). The larger the skew, the
+//                      more students a joining node holds waiting for the other sources.
+//   --types T,T,...    Content types to generate (default studentdata,exercisedata,exerciseworkdata,examdata).
+//   --json             Also write payloads.jsonl: one student per line, in the JSON format of
+//                      StudentDataItem to_json, for replaying as network packages.
+//   --seed N           Random seed (default 1).
+//   --out DIR          Output directory (default current directory).
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <numeric>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+
+namespace {
+   
+   /** The generator options. */
+   struct Options {
+      uint64_t students = 1000;
+      unsigned exercises = 10;
+      double overlap = 1.0;
+      std::string order = "random";
+      uint64_t skew = 0;
+      std::vector<std::string> types{"studentdata", "exercisedata", "exerciseworkdata", "examdata"};
+      bool json = false;
+      uint64_t seed = 1;
+      std::string outDir = ".";
+   };
+   
+   const char * FirstNames[] = {"Aino", "Eero", "Helmi", "Juho", "Kaisa", "Lauri", "Mari", "Niko", "Oona", "Pekka", "Sanna", "Timo", "Venla", "Ville"};
+   const char * LastNames[] = {"Heikkinen", "Hämäläinen", "Koskinen", "Korhonen", "Laine", "Mäkinen", "Nieminen", "Virtanen"};
+   const char * Programs[] = {"TOL", "TST", "SO", "EE", "PT"};
+   
+   /** Student ids are this plus the student's number. */
+   const uint64_t FirstId = 20000000;
+   
+   /** A fast hash, used as a deterministic random value for a student. */
+   uint64_t mix(uint64_t value) {
+      value += 0x9e3779b97f4a7c15ULL;
+      value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ULL;
+      value = (value ^ (value >> 27)) * 0x94d049bb133111ebULL;
+      return value ^ (value >> 31);
+   }
+   
+   /** A random value 0..limit-1 for a student and a property of the student. */
+   uint32_t pick(uint64_t seed, uint64_t student, uint64_t property, uint32_t limit) {
+      return static_cast<uint32_t>(mix(seed ^ mix(student * 64 + property)) % limit);
+   }
+   
+   /** The data of one student, derived from the student's number. */
+   struct Student {
+      uint64_t id;
+      const char * firstName;
+      const char * lastName;
+      const char * program;
+      int exam;
+      int project;
+      
+      Student(uint64_t seed, uint64_t number)
+      : id(FirstId + number),
+      firstName(FirstNames[pick(seed, number, 0, sizeof(FirstNames) / sizeof(FirstNames[0]))]),
+      lastName(LastNames[pick(seed, number, 1, sizeof(LastNames) / sizeof(LastNames[0]))]),
+      program(Programs[pick(seed, number, 2, sizeof(Programs) / sizeof(Programs[0]))]),
+      exam(static_cast<int>(pick(seed, number, 3, 31))),
+      project(static_cast<int>(pick(seed, number, 4, 41)))
+      {
+      }
+      
+      int exercise(uint64_t seed, uint64_t number, unsigned column) const {
+         return static_cast<int>(pick(seed, number, 8 + column, 6));
+      }
+   };
+   
+   /** Buffers output and writes it to a file in large chunks. */
+   class Output {
+   public:
+      explicit Output(const std::string & fileName) : file(std::fopen(fileName.c_str(), "wb")) {
+         buffer.reserve(ChunkSize + 4096);
+      }
+      ~Output() {
+         flush();
+         if (file) {
+            std::fclose(file);
+         }
+      }
+      bool isOpen() const { return file != nullptr; }
+      void text(const char * value) { buffer += value; }
+      void text(char value) { buffer += value; }
+      void number(uint64_t value) {
+         char digits[24];
+         buffer.append(digits, std::to_chars(digits, digits + sizeof(digits), value).ptr);
+      }
+      /** Ends a row, writing the buffer if it is full. */
+      void endRow() {
+         buffer += '\n';
+         if (buffer.size() >= ChunkSize) {
+            flush();
+         }
+      }
+   private:
+      void flush() {
+         if (file && !buffer.empty()) {
+            std::fwrite(buffer.data(), 1, buffer.size(), file);
+         }
+         buffer.clear();
+      }
+      static const std::size_t ChunkSize = 1 << 20;
+      std::FILE * file;
+      std::string buffer;
+   };
+   
+   /** The order in which the students are written into a file. */
+   std::vector<uint32_t> rowOrder(const Options & options, uint64_t fileSeed) {
+      std::vector<uint32_t> order(options.students);
+      std::iota(order.begin(), order.end(), 0);
+      if (options.order == "reverse") {
+         std::reverse(order.begin(), order.end());
+      }
+      uint64_t state = mix(fileSeed);
+      auto next = [&state] () { state = mix(state); return state; };
+      if (options.order == "random") {
+         for (std::size_t index = order.size(); index > 1; index--) {
+            std::swap(order[index - 1], order[next() % index]);
+         }
+      } else if (options.skew > 0) {
+         // Each row is sorted by its place plus a random 0..skew+1, ties keeping their order:
+         // rows more than skew places before it stay before it, and rows more than skew places
+         // after it stay after it, so no row moves more than skew places.
+         std::vector<std::pair<uint64_t, uint32_t>> keyed(order.size());
+         for (std::size_t index = 0; index < order.size(); index++) {
+            keyed[index] = std::make_pair(index + next() % (options.skew + 2), order[index]);
+         }
+         std::stable_sort(keyed.begin(), keyed.end(), [] (const std::pair<uint64_t, uint32_t> & first, const std::pair<uint64_t, uint32_t> & second) {
+            return first.first < second.first;
+         });
+         for (std::size_t index = 0; index < order.size(); index++) {
+            order[index] = keyed[index].second;
+         }
+      }
+      return order;
+   }
+   
+   /** True if the student is included in a file of the given type. */
+   bool included(const Options & options, const std::string & type, uint64_t number) {
+      if (type == "studentdata" || type == "summarydata" || options.overlap >= 1.0) {
+         return true;
+      }
+      const uint64_t typeHash = std::hash<std::string>()(type);
+      return static_cast<double>(mix(options.seed ^ mix(number ^ typeHash)) % 1000000) < options.overlap * 1000000.0;
+   }
+   
+   /** Writes one content type file. */
+   uint64_t writeFile(const Options & options, const std::string & type, uint64_t fileIndex) {
+      Output out(options.outDir + "/" + type + ".txt");
+      if (!out.isOpen()) {
+         std::cerr << "Could not open " << type << ".txt in " << options.outDir << std::endl;
+         return 0;
+      }
+      out.text(type.c_str());
+      out.endRow();
+      uint64_t rows = 0;
+      for (uint32_t number : rowOrder(options, options.seed * 31 + fileIndex)) {
+         if (!included(options, type, number)) {
+            continue;
+         }
+         const Student student(options.seed, number);
+         out.number(student.id);
+         if (type == "studentdata" || type == "summarydata") {
+            out.text('\t');
+            out.text(student.firstName);
+            out.text(' ');
+            out.text(student.lastName);
+            out.text('\t');
+            out.text(student.program);
+         }
+         if (type == "summarydata") {
+            int exercises = 0;
+            for (unsigned column = 0; column < options.exercises; column++) {
+               exercises += student.exercise(options.seed, number, column);
+            }
+            out.text('\t');
+            out.number(student.exam);
+            out.text('\t');
+            out.number(exercises);
+            out.text('\t');
+            out.number(student.project);
+         } else if (type == "exercisedata") {
+            for (unsigned column = 0; column < options.exercises; column++) {
+               out.text('\t');
+               out.number(student.exercise(options.seed, number, column));
+            }
+         } else if (type == "exerciseworkdata") {
+            out.text('\t');
+            out.number(student.project);
+         } else if (type == "examdata") {
+            out.text('\t');
+            out.number(student.exam);
+         }
+         out.endRow();
+         rows++;
+      }
+      return rows;
+   }
+   
+   /** Writes the students as JSON payloads, one per line. */
+   uint64_t writeJson(const Options & options) {
+      Output out(options.outDir + "/payloads.jsonl");
+      if (!out.isOpen()) {
+         std::cerr << "Could not open payloads.jsonl in " << options.outDir << std::endl;
+         return 0;
+      }
+      uint64_t rows = 0;
+      for (uint32_t number : rowOrder(options, options.seed * 31 + 1000)) {
+         const Student student(options.seed, number);
+         out.text("{\"courseprojectpoints\":");
+         out.number(student.project);
+         out.text(",\"exampoints\":");
+         out.number(student.exam);
+         // Like to_json, no exercise points if there are none.
+         if (options.exercises > 0) {
+            out.text(",\"exercisepoints\":[");
+            for (unsigned column = 0; column < options.exercises; column++) {
+               if (column > 0) {
+                  out.text(',');
+               }
+               out.number(student.exercise(options.seed, number, column));
+            }
+            out.text(']');
+         }
+         out.text(",\"id\":\"");
+         out.number(student.id);
+         out.text("\",\"name\":\"");
+         out.text(student.firstName);
+         out.text(' ');
+         out.text(student.lastName);
+         out.text("\",\"studyprogram\":\"");
+         out.text(student.program);
+         out.text("\"}");
+         out.endRow();
+         rows++;
+      }
+      return rows;
+   }
+   
+   void usage() {
+      std::cerr << "Usage: sne-datagen [--students N] [--exercises N] [--overlap 0..1] [--order sorted|reverse|random]" << std::endl
+         << "                   [--skew N] [--types T,T,...] [--json] [--seed N] [--out DIR]" << std::endl;
+   }
+   
+   bool parseOptions(int argc, char ** argv, Options & options) {
+      try {
+         for (int index = 1; index < argc; index++) {
+            const std::string option = argv[index];
+            if (option == "--json") {
+               options.json = true;
+               continue;
+            }
+            if (index + 1 >= argc) {
+               return false;
+            }
+            const std::string value = argv[++index];
+            if (option == "--students") {
+               options.students = std::stoull(value);
+            } else if (option == "--exercises") {
+               options.exercises = static_cast<unsigned>(std::stoul(value));
+            } else if (option == "--overlap") {
+               options.overlap = std::stod(value);
+            } else if (option == "--order") {
+               options.order = value;
+            } else if (option == "--skew") {
+               options.skew = std::stoull(value);
+            } else if (option == "--types") {
+               options.types.clear();
+               for (std::size_t begin = 0; begin <= value.length(); ) {
+                  std::size_t end = std::min(value.find(',', begin), value.length());
+                  options.types.push_back(value.substr(begin, end - begin));
+                  begin = end + 1;
+               }
+            } else if (option == "--seed") {
+               options.seed = std::stoull(value);
+            } else if (option == "--out") {
+               options.outDir = value;
+            } else {
+               return false;
+            }
+         }
+      } catch (const std::exception &) {
+         return false;
+      }
+      if (options.order != "sorted" && options.order != "reverse" && options.order != "random") {
+         return false;
+      }
+      if (options.students > UINT32_MAX) {
+         return false;
+      }
+      for (const std::string & type : options.types) {
+         if (type != "summarydata" && type != "studentdata" && type != "exercisedata" && type != "exerciseworkdata" && type != "examdata") {
+            std::cerr << "Unknown content type " << type << std::endl;
+            return false;
+         }
+      }
+      return true;
+   }
+   
+} //namespace
+
+
+int main(int argc, char ** argv) {
+   Options options;
+   if (!parseOptions(argc, argv, options)) {
+      usage();
+      return EXIT_FAILURE;
+   }
+   const auto start = std::chrono::steady_clock::now();
+   // Each file is written by its own thread.
+   std::vector<uint64_t> rows(options.types.size() + 1, 0);
+   std::vector<std::thread> writers;
+   for (std::size_t index = 0; index < options.types.size(); index++) {
+      writers.emplace_back([&options, &rows, index] {
+         rows[index] = writeFile(options, options.types[index], index);
+      });
+   }
+   if (options.json) {
+      writers.emplace_back([&options, &rows] {
+         rows.back() = writeJson(options);
+      });
+   }
+   for (std::thread & writer : writers) {
+      writer.join();
+   }
+   const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+   const uint64_t total = std::accumulate(rows.begin(), rows.end(), uint64_t(0));
+   for (std::size_t index = 0; index < options.types.size(); index++) {
+      std::cout << options.types[index] << ".txt: " << rows[index] << " rows" << std::endl;
+   }
+   if (options.json) {
+      std::cout << "payloads.jsonl: " << rows.back() << " rows" << std::endl;
+   }
+   std::cout << total << " rows in " << seconds << " s (" << static_cast<uint64_t>(total / std::max(seconds, 1e-9)) << " rows/s)" << std::endl;
+   return EXIT_SUCCESS;
+}
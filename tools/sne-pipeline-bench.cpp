@@ -0,0 +1,455 @@
+//
+//  sne-pipeline-bench.cpp
+//  PipesAndFiltersFramework
+//
+//  Created by Antti Juustila on 19.10.2026.
+//  Copyright (c) 2026 Antti Juustila. All rights reserved.
+//
+
+// Measures the throughput of a student pipeline in one process. ProcessorNodes are wired
+// as in a StudentPassing deployment, with local stand-ins for the network between them.
+// In the join scenario (the default), the students come to node 1 from two sources, the
+// previous node and a file, and StudentHandler joins them:
+//
+//   replayer: student JSON payloads -> network stand-in
+//   node 1:   StudentInputHandler -> StudentHandler (joins with exercisedata) -> GradingHandler -> StudentNetOutputHandler -> network stand-in
+//   node 2:   StudentInputHandler -> StudentWriterHandler -> (exit tap)
+//
+// In the plain scenario, node 1 reads complete students from a summarydata file, without joining:
+//
+//   node 1:   PlainStudentFileHandler -> (entry tap) -> GradingHandler -> StudentNetOutputHandler -> network stand-in
+//
+// The network stand-ins hand the JSON payloads to the next node on their own threads, like the
+// network reader of a node would. Each student is timestamped when it enters node 1 (the payload
+// is replayed, or the student is read) and when it has been written, giving the per record latency.
+// Records per second, p50/p99 latency and the peak memory (max RSS) are reported, so that changes
+// in the library can be compared in the same scenario.
+//
+// Usage: sne-pipeline-bench [--scenario S] [--students N] [--data FILE] [--payloads FILE] [--workers N] [--out FILE]
+//   --scenario S     join (default) or plain, see above.
+//   --students N     Generate the data for N students (default 100000).
+//   --data FILE      Use this file read by node 1 instead: exercisedata in the join scenario,
+//                    summarydata in the plain one (e.g. generated by sne-datagen).
+//   --payloads FILE  In the join scenario, replay these student payloads with --data, one JSON
+//                    per line (e.g. payloads.jsonl generated by sne-datagen --json).
+//   --workers N      Grade in a worker pool of N threads (default 0: grade in the passing thread).
+//   --out FILE       The report file written by node 2 (default sne-bench-report.txt). The generated
+//                    data files are named after it, and removed at the end.
+//
+// Fails if no records were written, or if the data was generated and not every student was written.
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <sys/resource.h>
+
+#include <ProcessorNode/ProcessorNode.h>
+#include <ProcessorNode/DataHandler.h>
+#include <ProcessorNode/Package.h>
+
+#include <StudentNodeElements/PlainStudentFileHandler.h>
+#include <StudentNodeElements/StudentHandler.h>
+#include <StudentNodeElements/GradingHandler.h>
+#include <StudentNodeElements/StudentNetOutputHandler.h>
+#include <StudentNodeElements/StudentInputHandler.h>
+#include <StudentNodeElements/StudentWriterHandler.h>
+#include <StudentNodeElements/StudentDataItem.h>
+#include <StudentNodeElements/StudentKey.h>
+
+
+namespace {
+   
+   using Clock = std::chrono::steady_clock;
+   
+   /** Per record latencies, from the entry tap to the exit tap. */
+   class LatencyRecorder {
+   public:
+      void entered(const OHARStudent::StudentKey & key) {
+         Clock::time_point now = Clock::now();
+         std::lock_guard<std::mutex> guard(lock);
+         started[key] = now;
+         enteredCount++;
+      }
+      void exited(const OHARStudent::StudentKey & key) {
+         Clock::time_point now = Clock::now();
+         std::lock_guard<std::mutex> guard(lock);
+         auto iter = started.find(key);
+         if (iter != started.end()) {
+            latencies.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(now - iter->second).count());
+            started.erase(iter);
+         }
+         exitedCount++;
+         lastExit = now;
+      }
+      bool allExited() {
+         std::lock_guard<std::mutex> guard(lock);
+         return enteredCount > 0 && enteredCount == exitedCount;
+      }
+      std::size_t getExited() {
+         std::lock_guard<std::mutex> guard(lock);
+         return exitedCount;
+      }
+      Clock::time_point getLastExit() {
+         std::lock_guard<std::mutex> guard(lock);
+         return lastExit;
+      }
+      /** @returns The latency at the percentile (0..100), in microseconds. */
+      double percentile(double which) {
+         std::lock_guard<std::mutex> guard(lock);
+         if (latencies.empty()) {
+            return 0.0;
+         }
+         std::size_t index = std::min(latencies.size() - 1, static_cast<std::size_t>(which / 100.0 * latencies.size()));
+         std::nth_element(latencies.begin(), latencies.begin() + index, latencies.end());
+         return latencies[index] / 1000.0;
+      }
+   private:
+      std::mutex lock;
+      std::unordered_map<OHARStudent::StudentKey, Clock::time_point> started;
+      std::vector<int64_t> latencies;
+      std::size_t enteredCount = 0;
+      std::size_t exitedCount = 0;
+      Clock::time_point lastExit;
+   };
+   
+   /** Timestamps the students passing by, at the entry or the exit of the pipeline. */
+   class TapHandler : public OHARBase::DataHandler {
+   public:
+      TapHandler(LatencyRecorder & recorder, bool entry) : recorder(recorder), entry(entry) {
+      }
+      bool consume(OHARBase::Package & data) override {
+         if (data.getType() == OHARBase::Package::Data) {
+            const OHARStudent::StudentDataItem * student = dynamic_cast<const OHARStudent::StudentDataItem*>(data.getPayloadObject());
+            if (student) {
+               if (entry) {
+                  recorder.entered(student->getKey());
+               } else {
+                  recorder.exited(student->getKey());
+               }
+            }
+         }
+         return false;
+      }
+   private:
+      LatencyRecorder & recorder;
+      bool entry;
+   };
+   
+   /**
+    Stands in for the network between the nodes: the JSON payloads and the control packages
+    (e.g. the "flush" ending a batch) are queued and handed to the first handler of the next node
+    on a separate thread, which then passes them on to the other handlers of that node.
+    */
+   class NetworkStandIn : public OHARBase::DataHandler {
+   public:
+      NetworkStandIn(OHARBase::ProcessorNode & nextNode, OHARBase::DataHandler & firstHandler)
+      : nextNode(nextNode), firstHandler(firstHandler), running(true) {
+         receiver = std::thread(&NetworkStandIn::deliver, this);
+      }
+      ~NetworkStandIn() {
+         {
+            std::lock_guard<std::mutex> guard(lock);
+            running = false;
+         }
+         changed.notify_all();
+         receiver.join();
+      }
+      bool consume(OHARBase::Package & data) override {
+         if (data.getType() != OHARBase::Package::NoType) {
+            send(data.getPayloadString(), data.getType());
+         }
+         return true; // Sent to the next node.
+      }
+      /** Queues a package to the next node. Waits if the next node is too far behind.
+       @param payload The JSON payload, or the control command.
+       @param type The type of the package. */
+      void send(std::string payload, OHARBase::Package::Type type = OHARBase::Package::Data) {
+         std::unique_lock<std::mutex> guard(lock);
+         changed.wait(guard, [this] { return queue.size() < MaxQueued; });
+         queue.push_back(std::make_pair(type, std::move(payload)));
+         changed.notify_all();
+      }
+   private:
+      void deliver() {
+         std::unique_lock<std::mutex> guard(lock);
+         while (true) {
+            changed.wait(guard, [this] { return !queue.empty() || !running; });
+            if (queue.empty()) {
+               break;
+            }
+            std::pair<OHARBase::Package::Type, std::string> sent = std::move(queue.front());
+            queue.pop_front();
+            changed.notify_all();
+            guard.unlock();
+            OHARBase::Package package;
+            package.setType(sent.first);
+            package.setPayload(sent.second);
+            if (!firstHandler.consume(package)) {
+               nextNode.passToNextHandlers(&firstHandler, package);
+            }
+            guard.lock();
+         }
+      }
+      static const std::size_t MaxQueued = 10000;
+      OHARBase::ProcessorNode & nextNode;
+      OHARBase::DataHandler & firstHandler;
+      std::deque<std::pair<OHARBase::Package::Type, std::string>> queue;
+      bool running;
+      std::mutex lock;
+      std::condition_variable changed;
+      std::thread receiver;
+   };
+   
+   /** Writes a summarydata file with the given number of students. */
+   bool generateData(const std::string & fileName, std::size_t students) {
+      std::ofstream out(fileName, std::ios::trunc);
+      out << "summarydata\n";
+      for (std::size_t number = 0; number < students; number++) {
+         out << (20000000 + number) << "\tStudent " << number << "\tTOL\t" << (number * 7 % 31)
+            << "\t" << (number * 13 % 51) << "\t" << (number * 17 % 41) << "\n";
+      }
+      return static_cast<bool>(out);
+   }
+   
+   /** Writes an exercisedata file with the given number of students, joined with the payloads. */
+   bool generateExercises(const std::string & fileName, std::size_t students) {
+      std::ofstream out(fileName, std::ios::trunc);
+      out << "exercisedata\n";
+      for (std::size_t number = 0; number < students; number++) {
+         out << (20000000 + number);
+         for (std::size_t exercise = 0; exercise < 10; exercise++) {
+            out << "\t" << ((number + exercise) * 5 % 6);
+         }
+         out << "\n";
+      }
+      return static_cast<bool>(out);
+   }
+   
+   /** Writes the payloads replayed into node 1: the JSON of each student, one per line. */
+   bool generatePayloads(const std::string & fileName, std::size_t students) {
+      std::ofstream out(fileName, std::ios::trunc);
+      for (std::size_t number = 0; number < students; number++) {
+         OHARStudent::StudentDataItem student;
+         student.setId(std::to_string(20000000 + number));
+         student.setName("Student " + std::to_string(number));
+         student.setStudyProgram("TOL");
+         student.setExamPoints(static_cast<int>(number * 7 % 31));
+         student.setCourseProjectPoints(static_cast<int>(number * 17 % 41));
+         out << nlohmann::json(student).dump() << "\n";
+      }
+      return static_cast<bool>(out);
+   }
+   
+   /** Replays the payloads of a file into a node as if a previous node sent them, ending
+    with the end of the batch. The students are timestamped as they enter the node. */
+   void replay(const std::string & fileName, NetworkStandIn & network, LatencyRecorder & recorder) {
+      std::ifstream in(fileName);
+      std::string payload;
+      while (std::getline(in, payload)) {
+         if (payload.empty()) {
+            continue;
+         }
+         const nlohmann::json json = nlohmann::json::parse(payload, nullptr, false);
+         if (json.is_object() && json.contains("id") && json["id"].is_string()) {
+            recorder.entered(OHARStudent::StudentKey(json["id"].get<std::string>()));
+            network.send(std::move(payload));
+         }
+      }
+      network.send("flush", OHARBase::Package::Control);
+   }
+   
+   void usage() {
+      std::cerr << "Usage: sne-pipeline-bench [--scenario join|plain] [--students N] [--data FILE] [--payloads FILE] [--workers N] [--out FILE]" << std::endl;
+   }
+   
+} //namespace
+
+
+int main(int argc, char ** argv) {
+   std::size_t students = 100000;
+   std::size_t workers = 0;
+   std::string scenario = "join";
+   std::string dataFile;
+   std::string payloadFile;
+   std::string outputFile = "sne-bench-report.txt";
+   for (int index = 1; index < argc; index += 2) {
+      const std::string option = argv[index];
+      if (index + 1 >= argc) {
+         usage();
+         return EXIT_FAILURE;
+      }
+      const std::string value = argv[index + 1];
+      try {
+         if (option == "--scenario") {
+            scenario = value;
+         } else if (option == "--students") {
+            students = std::stoul(value);
+         } else if (option == "--data") {
+            dataFile = value;
+         } else if (option == "--payloads") {
+            payloadFile = value;
+         } else if (option == "--workers") {
+            workers = std::stoul(value);
+         } else if (option == "--out") {
+            outputFile = value;
+         } else {
+            usage();
+            return EXIT_FAILURE;
+         }
+      } catch (const std::exception &) {
+         std::cerr << "Invalid value for " << option << ": " << value << std::endl;
+         usage();
+         return EXIT_FAILURE;
+      }
+   }
+   if (scenario != "join" && scenario != "plain") {
+      usage();
+      return EXIT_FAILURE;
+   }
+   const bool join = scenario == "join";
+   if (join && dataFile.empty() != payloadFile.empty()) {
+      std::cerr << "Give both --data and --payloads, or neither, so that the students match." << std::endl;
+      return EXIT_FAILURE;
+   }
+   std::vector<std::string> generatedFiles;
+   if (dataFile.empty()) {
+      // Named after the report, so that benchmarks run at the same time do not share the files.
+      dataFile = outputFile + ".data.txt";
+      generatedFiles.push_back(dataFile);
+      bool written = join ? generateExercises(dataFile, students) : generateData(dataFile, students);
+      if (written && join) {
+         payloadFile = outputFile + ".payloads.jsonl";
+         generatedFiles.push_back(payloadFile);
+         written = generatePayloads(payloadFile, students);
+      }
+      if (!written) {
+         std::cerr << "Could not write the data files." << std::endl;
+         for (const std::string & file : generatedFiles) {
+            std::remove(file.c_str());
+         }
+         return EXIT_FAILURE;
+      }
+   }
+   
+   LatencyRecorder recorder;
+   Clock::time_point start;
+   {
+      OHARBase::ProcessorNode node1("BenchReader");
+      OHARBase::ProcessorNode node2("BenchWriter");
+      node1.setDataFileName(dataFile);
+      node2.setOutputFileName(outputFile);
+      
+      OHARStudent::StudentInputHandler input;
+      OHARStudent::StudentWriterHandler writer(node2);
+      TapHandler exitTap(recorder, false);
+      node2.addHandler(&input);
+      node2.addHandler(&writer);
+      node2.addHandler(&exitTap);
+      
+      // Only the handlers of the scenario are created, so that the others do not start threads.
+      std::unique_ptr<OHARStudent::StudentInputHandler> joinInput;
+      std::unique_ptr<OHARStudent::StudentHandler> joiner;
+      std::unique_ptr<OHARStudent::PlainStudentFileHandler> reader;
+      TapHandler entryTap(recorder, true);
+      OHARStudent::GradingHandler grading;
+      OHARStudent::StudentNetOutputHandler netOutput;
+      NetworkStandIn network(node2, input);
+      if (workers > 0) {
+         grading.enableWorkerPool(node1, workers);
+      }
+      if (join) {
+         joinInput = std::make_unique<OHARStudent::StudentInputHandler>();
+         joiner = std::make_unique<OHARStudent::StudentHandler>(node1);
+         node1.addHandler(joinInput.get());
+         node1.addHandler(joiner.get());
+      } else {
+         reader = std::make_unique<OHARStudent::PlainStudentFileHandler>(node1);
+         node1.addHandler(reader.get());
+         node1.addHandler(&entryTap);
+      }
+      node1.addHandler(&grading);
+      node1.addHandler(&netOutput);
+      node1.addHandler(&network);
+      // Declared last, so that it stops delivering before the handlers of node 1 are destroyed.
+      std::unique_ptr<NetworkStandIn> previousNode;
+      if (join) {
+         previousNode = std::make_unique<NetworkStandIn>(node1, *joinInput);
+      }
+      
+      start = Clock::now();
+      std::thread replayer;
+      if (join) {
+         replayer = std::thread(replay, payloadFile, std::ref(*previousNode), std::ref(recorder));
+      }
+      OHARBase::Package command;
+      command.setType(OHARBase::Package::Control);
+      command.setPayload(std::string("readfile"));
+      if (join) {
+         joiner->consume(command);
+         while (!joiner->waitForFileRead(std::chrono::milliseconds(100))) {
+         }
+      } else {
+         reader->consume(command);
+         while (!reader->waitForFileRead(std::chrono::milliseconds(100))) {
+         }
+      }
+      if (replayer.joinable()) {
+         replayer.join();
+      }
+      // Reading is done; wait until the students in flight have been written.
+      std::size_t previous = 0;
+      Clock::time_point progress = Clock::now();
+      while (!recorder.allExited()) {
+         std::this_thread::sleep_for(std::chrono::milliseconds(10));
+         std::size_t exited = recorder.getExited();
+         if (exited != previous) {
+            previous = exited;
+            progress = Clock::now();
+         } else if (Clock::now() - progress > std::chrono::seconds(10)) {
+            std::cerr << "No progress in 10 s, some records were lost." << std::endl;
+            break;
+         }
+      }
+      // Stop the previous node, and let the grading workers pass on the students they still
+      // have, before the handlers following them are destroyed.
+      previousNode.reset();
+      OHARBase::Package endOfRun;
+      endOfRun.setType(OHARBase::Package::Control);
+      endOfRun.setPayload(std::string("flush"));
+      grading.consume(endOfRun);
+   }
+   
+   const std::size_t records = recorder.getExited();
+   const double seconds = std::chrono::duration<double>(recorder.getLastExit() - start).count();
+   struct rusage usage;
+   getrusage(RUSAGE_SELF, &usage);
+   std::cout << "scenario:     " << scenario << std::endl;
+   std::cout << "records:      " << records << std::endl;
+   std::cout << "records/s:    " << static_cast<uint64_t>(records / std::max(seconds, 1e-9)) << std::endl;
+   std::cout << "latency p50:  " << recorder.percentile(50.0) << " us" << std::endl;
+   std::cout << "latency p99:  " << recorder.percentile(99.0) << " us" << std::endl;
+   std::cout << "peak RSS:     " << usage.ru_maxrss / 1024 << " MiB" << std::endl;
+   for (const std::string & file : generatedFiles) {
+      std::remove(file.c_str());
+   }
+   if (!generatedFiles.empty() && records != students) {
+      std::cerr << "Wrote " << records << " records of " << students << " students." << std::endl;
+      return EXIT_FAILURE;
+   }
+   return records > 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}